@@ -0,0 +1,83 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+// Compares directory::get_child at the bottom of a deep tree with and without a cached directory handle.
+//
+// Build and run from the repository root :
+//	g++ -std=c++11 -O2 -pthread -Iinclude benchmarks/directory_handles.cpp src/asmith/files/*.cpp -o directory_handles
+//	./directory_handles [parent directory] [depth]
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "asmith/files/master.hpp"
+
+using namespace asmith;
+
+enum {
+	DEFAULT_DEPTH = 32,
+	CHILD_COUNT = 64,
+	ROUNDS = 2000
+};
+
+// Returns the number of get_child calls per second on every child of aDirectory
+static double measure(directory& aDirectory, const std::vector<std::string>& aNames, size_t& aFound) {
+	const auto begin = std::chrono::steady_clock::now();
+	for(int i = 0; i < ROUNDS; ++i) {
+		for(const std::string& j : aNames) if(aDirectory.get_child(j.c_str())) ++aFound;
+	}
+	const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - begin;
+	return (static_cast<double>(ROUNDS) * aNames.size()) / seconds.count();
+}
+
+int main(int argc, char** argv) {
+	// Always work in a new directory so that nothing which already exists is destroyed
+	const std::shared_ptr<directory> parent = argc > 1 ? directory::get_reference(argv[1]) : directory::get_temporary_directory();
+	std::shared_ptr<directory> root = parent->get_directory(("asmith_files_handles_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())).c_str());
+	const int depth = argc > 2 ? std::stoi(argv[2]) : DEFAULT_DEPTH;
+	root->create(FILE_READ | FILE_WRITE);
+
+	// Each level adds a component the kernel must resolve when the full path is used
+	std::shared_ptr<directory> leaf = root;
+	for(int i = 0; i < depth; ++i) {
+		leaf = leaf->get_directory(("level_" + std::to_string(i)).c_str());
+		leaf->create(FILE_READ | FILE_WRITE);
+	}
+
+	std::vector<std::string> names;
+	for(int i = 0; i < CHILD_COUNT; ++i) {
+		names.push_back(std::to_string(i) + ".txt");
+		leaf->get_file(names.back().c_str())->create(FILE_READ | FILE_WRITE);
+	}
+
+	size_t found = 0;
+	leaf->cache_handle(false);
+	measure(*leaf, names, found);
+	const double uncached = measure(*leaf, names, found);
+
+	leaf->cache_handle(true);
+	measure(*leaf, names, found);
+	const double cached = measure(*leaf, names, found);
+
+	const size_t expected = static_cast<size_t>(ROUNDS) * CHILD_COUNT * 4;
+	std::printf("depth\tcache_handle(false)\tcache_handle(true)\tspeedup\n");
+	std::printf("%d\t%.3g calls/s\t\t%.3g calls/s\t\t%.2fx\n", depth, uncached, cached, cached / uncached);
+
+	root->destroy();
+	if(found != expected) {
+		std::printf("FAIL : found %llu of %llu children\n", static_cast<unsigned long long>(found), static_cast<unsigned long long>(expected));
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+// Measures state query throughput as reader threads are added while one writer creates and destroys.
+//
+// Build and run from the repository root :
+//	g++ -std=c++11 -O2 -pthread -Iinclude benchmarks/filesystem_object_readers.cpp src/asmith/files/*.cpp -o filesystem_object_readers
+//	./filesystem_object_readers [parent directory] [max readers]
+//
+// Readers double from 1 up to the maximum, which defaults to the number of hardware threads.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "asmith/files/master.hpp"
+
+using namespace asmith;
+
+// Keeps the query results observable so the loops are not optimised away
+std::atomic<uint64_t> SINK(0);
+
+enum {
+	OBJECT_COUNT = 64,
+	DURATION_MS = 500
+};
+
+int main(int argc, char** argv) {
+	// Always work in a new directory so that nothing which already exists is destroyed
+	const std::shared_ptr<directory> parent = argc > 1 ? directory::get_reference(argv[1]) : directory::get_temporary_directory();
+	std::shared_ptr<directory> root = parent->get_directory(("asmith_files_readers_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())).c_str());
+	root->create(FILE_READ | FILE_WRITE);
+
+	std::vector<std::shared_ptr<filesystem_object>> objects;
+	for(int i = 0; i < OBJECT_COUNT; ++i) objects.push_back(root->get_file((std::to_string(i) + ".txt").c_str()));
+
+	const unsigned maxReaders = argc > 2 ? static_cast<unsigned>(std::stoul(argv[2])) : std::max(std::thread::hardware_concurrency(), 1u);
+	std::printf("readers\tqueries/s\tper reader\tscaling\twriter ops/s\n");
+	double baseline = 0.0;
+	for(unsigned readerCount = 1; readerCount <= maxReaders; readerCount *= 2) {
+		std::atomic<bool> done(false);
+		std::atomic<uint64_t> queries(0);
+		std::atomic<uint64_t> writes(0);
+
+		std::thread writer([&]() {
+			uint64_t count = 0;
+			while(! done) {
+				std::shared_ptr<filesystem_object>& object = objects[count % OBJECT_COUNT];
+				if(object->exists()) object->destroy();
+				else object->create(FILE_READ | FILE_WRITE);
+				++count;
+			}
+			writes = count;
+		});
+
+		std::vector<std::thread> readers;
+		for(unsigned i = 0; i < readerCount; ++i) readers.push_back(std::thread([&]() {
+			uint64_t count = 0;
+			uint64_t sink = 0;
+			while(! done) {
+				for(const std::shared_ptr<filesystem_object>& j : objects) sink += j->exists() + j->is_hidden();
+				count += OBJECT_COUNT;
+			}
+			queries += count;
+			SINK += sink;
+		}));
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(DURATION_MS));
+		done = true;
+		writer.join();
+		for(std::thread& i : readers) i.join();
+
+		const double seconds = DURATION_MS / 1000.0;
+		const double rate = queries / seconds;
+		if(readerCount == 1) baseline = rate;
+		std::printf("%u\t%.3g\t\t%.3g\t\t%.2fx\t%.3g\n", readerCount, rate, rate / readerCount, rate / baseline, writes / seconds);
+	}
+
+	root->destroy();
+	return 0;
+}
@@ -0,0 +1,73 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#ifndef ASMITH_FILES_BUNDLE_HPP
+#define ASMITH_FILES_BUNDLE_HPP
+
+#include <string>
+#include <vector>
+#include "directory_listing.hpp"
+
+namespace asmith {
+
+	/*!
+		\brief Read only view of a bundle file written by directory::pack.
+		\detail A bundle stores the contents of every file back to back followed by an index of
+		names, offsets and metadata, and a fixed size footer locating the index. The whole bundle
+		is memory mapped so single files can be read without unpacking.
+	*/
+	class bundle {
+	private:
+		bundle(bundle&&) = delete;
+		bundle(const bundle&) = delete;
+		bundle& operator=(bundle&&) = delete;
+		bundle& operator=(const bundle&) = delete;
+	private:
+		struct entry {
+			std::string name;
+			uint64_t offset;
+			uint64_t size;
+			int64_t modified;
+			directory_listing::type type;
+		};
+
+		std::vector<entry> mEntries;
+		const uint8_t* mData;
+		size_t mSize;
+#ifdef _WIN32
+		void* mFile;
+		void* mMapping;
+#else
+		int mFile;
+#endif
+
+		void release() throw();
+	public:
+		static void write(const std::string& aRoot, const directory_listing& aListing, const char* aPath);
+
+		bundle(const char* aPath);
+		~bundle();
+
+		size_t size() const throw();
+		size_t find(const char* aName) const throw();
+
+		const char* get_name(const size_t aIndex) const throw();
+		directory_listing::type get_type(const size_t aIndex) const throw();
+		uint64_t get_size(const size_t aIndex) const throw();
+		int64_t get_modified(const size_t aIndex) const throw();
+		const uint8_t* get_data(const size_t aIndex) const throw();
+
+		void unpack(const char* aPath, const size_t aThreads = 0) const;
+	};
+}
+#endif
@@ -0,0 +1,88 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#ifndef ASMITH_FILES_CONTENT_SEARCH_HPP
+#define ASMITH_FILES_CONTENT_SEARCH_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
+#include "directory.hpp"
+
+namespace asmith {
+	// The default flags are SEARCH_SKIP_BINARY, so pass it as well when combining other flags, e.g. SEARCH_MEMORY_MAP alone also scans binary files
+	enum {
+		SEARCH_SKIP_BINARY	= 1 << 0,	//!< Skip files with a zero byte in their first 8 KiB
+		SEARCH_FIRST_MATCH	= 1 << 1,	//!< Report at most one match per file
+		SEARCH_MEMORY_MAP	= 1 << 2	//!< Map files instead of reading them, see content_search
+	};
+
+	struct content_match {
+		std::string path;	//!< Full path of the file
+		uint64_t offset;	//!< Byte offset of the match in the file
+		size_t pattern;		//!< Index into the patterns passed to content_search
+	};
+
+	/*!
+		\brief Searches every file under a directory for one or more byte literals.
+		\detail Files are read in large blocks and scanned by a pool of worker threads, matches are
+		returned through next() while the scan is still running. SEARCH_MEMORY_MAP maps each file
+		instead, which avoids a copy but raises SIGBUS if a file is truncated during the scan, so it
+		should only be used on trees that are not being written to.
+	*/
+	class content_search {
+	private:
+		content_search(content_search&&) = delete;
+		content_search(const content_search&) = delete;
+		content_search& operator=(content_search&&) = delete;
+		content_search& operator=(const content_search&) = delete;
+	private:
+		enum {
+			MAX_QUEUED_MATCHES = 4096,
+			READ_BLOCK_SIZE = 1 << 20
+		};
+
+		const std::string mRoot;
+		const std::vector<std::string> mPatterns;
+		const uint32_t mFlags;
+		size_t mOverlap;
+		std::vector<std::vector<uint32_t>> mCandidates;
+		std::vector<uint8_t> mFirstBytes;
+		directory_listing mListing;
+		std::vector<std::thread> mThreads;
+		std::deque<content_match> mMatches;
+		mutable std::mutex mLock;
+		std::condition_variable mReady;
+		std::condition_variable mSpace;
+		std::atomic<size_t> mNext;
+		std::atomic<bool> mCancelled;
+		size_t mActive;
+
+		void worker();
+		void search_file(const std::string&, std::vector<uint8_t>&, std::vector<content_match>&);
+		void map_file(const std::string&, std::vector<content_match>&);
+		void scan(const uint8_t*, const size_t, const size_t, const uint64_t, const std::string&, std::vector<content_match>&) const;
+		void verify(const uint8_t*, const size_t, const size_t, const uint64_t, const std::string&, std::vector<content_match>&) const;
+		void publish(std::vector<content_match>&);
+	public:
+		content_search(const std::shared_ptr<directory>& aDirectory, const std::vector<std::string>& aPatterns, const uint32_t aFlags = SEARCH_SKIP_BINARY, const size_t aThreads = 0);
+		~content_search();
+
+		bool next(content_match&);
+		void cancel() throw();
+		bool is_finished() const throw();
+	};
+}
+#endif
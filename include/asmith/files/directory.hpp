@@ -15,16 +15,23 @@
 #define ASMITH_FILES_DIRECTORY_HPP
 
 #include<vector>
+#include <atomic>
 #include "filesystem_object.hpp"
 #include "file.hpp"
+#include "directory_listing.hpp"
+#include "directory_diff.hpp"
+#include "io_scheduler.hpp"
 
 namespace asmith {
 	class directory : public filesystem_object {
 	protected:
 		friend filesystem_object;
 
+		std::atomic<bool> mCacheHandle;
+
 		directory();
 		directory(const char* aPath);
+		directory(const char* aPath, const uint32_t aFlags);
 		
 		// Inherited from filesystem_object
 		uint32_t get_flags() const override;
@@ -32,12 +39,35 @@ namespace asmith {
 		static std::shared_ptr<directory> get_temporary_directory();
 		static std::shared_ptr<directory> get_current_directory();
 		static std::shared_ptr<directory> get_reference(const char*);
+		static size_t get_handle_limit() throw();
+		static void set_handle_limit(const size_t);
 		~directory();
 
 		std::shared_ptr<filesystem_object> get_child(const char*) const;
 		std::shared_ptr<file> get_file(const char*) const;
 		std::shared_ptr<directory> get_directory(const char*) const;
 		std::vector<std::shared_ptr<filesystem_object>> get_children() const ;
+		directory_listing get_listing(const bool aRecursive = false) const;
+		void get_listing(directory_listing&, const bool aRecursive = false) const;
+		std::shared_ptr<file> pack(const char* aPath) const;
+		std::vector<diff_entry> diff(const std::shared_ptr<directory>& aOther, const uint32_t aFlags = 0, const size_t aThreads = 0) const;
+
+		void destroy(io_scheduler&, const io_priority);
+		std::shared_ptr<filesystem_object> copy(const char* aPath, io_scheduler&, const io_priority);
+
+		bool is_handle_cached() const throw();
+
+		/*!
+			\brief Keep this directory open so that child lookups do not resolve the full path each time.
+			\detail The open handle is shared through a process wide pool keyed by path, which is
+			limited by set_handle_limit. The handle pins the directory that was at the path when it
+			was opened: if that directory is renamed, or removed and recreated outside this object,
+			get_child, get_children and get_listing keep reading the old directory until the handle
+			is dropped. get_children can then return paths that no longer exist. Call
+			cache_handle(false) after such a change. destroy drops the handle itself. Disabling the
+			cache while another thread is using the handle closes it when that thread finishes.
+		*/
+		void cache_handle(const bool);
 		
 		// Inherited from filesystem_object
 		
@@ -0,0 +1,37 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#ifndef ASMITH_FILES_DIRECTORY_DIFF_HPP
+#define ASMITH_FILES_DIRECTORY_DIFF_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace asmith {
+	enum {
+		DIFF_COMPARE_CONTENTS	= 1 << 0
+	};
+
+	struct diff_entry {
+		enum type : uint8_t {
+			ADDED,
+			REMOVED,
+			TYPE_CHANGED,
+			MODIFIED
+		};
+
+		std::string name;
+		type change;
+	};
+}
+#endif
@@ -0,0 +1,98 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#ifndef ASMITH_FILES_DIRECTORY_LISTING_HPP
+#define ASMITH_FILES_DIRECTORY_LISTING_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace asmith {
+
+	/*!
+		\brief Struct-of-arrays listing of directory entries.
+		\detail Names are stored in one contiguous blob of null terminated strings, all other
+		properties are stored in parallel arrays indexed by entry.
+	*/
+	class directory_listing {
+	public:
+		enum type : uint8_t {
+			TYPE_FILE,
+			TYPE_DIRECTORY,
+			TYPE_OTHER
+		};
+	private:
+		std::vector<char> mNames;
+		std::vector<size_t> mNameOffsets;
+		std::vector<uint8_t> mTypes;
+		std::vector<uint64_t> mSizes;
+		std::vector<int64_t> mModified;
+		std::vector<uint64_t> mInodes;
+	public:
+		directory_listing() : mNameOffsets(1, 0) {}
+		~directory_listing() {}
+
+		inline size_t size() const throw() { return mTypes.size(); }
+		inline bool empty() const throw() { return mTypes.empty(); }
+
+		inline void clear() {
+			mNames.clear();
+			mNameOffsets.assign(1, 0);
+			mTypes.clear();
+			mSizes.clear();
+			mModified.clear();
+			mInodes.clear();
+		}
+
+		inline void reserve(const size_t aEntries, const size_t aNameBytes) {
+			mNames.reserve(aNameBytes);
+			mNameOffsets.reserve(aEntries + 1);
+			mTypes.reserve(aEntries);
+			mSizes.reserve(aEntries);
+			mModified.reserve(aEntries);
+			mInodes.reserve(aEntries);
+		}
+
+		inline void push_back(const char* aName, const size_t aLength, const type aType, const uint64_t aSize, const int64_t aModified, const uint64_t aInode) {
+			mNames.insert(mNames.end(), aName, aName + aLength);
+			mNames.push_back('\0');
+			mNameOffsets.push_back(mNames.size());
+			mTypes.push_back(aType);
+			mSizes.push_back(aSize);
+			mModified.push_back(aModified);
+			mInodes.push_back(aInode);
+		}
+
+		inline void push_back(const char* aName, const type aType, const uint64_t aSize, const int64_t aModified, const uint64_t aInode) {
+			push_back(aName, strlen(aName), aType, aSize, aModified, aInode);
+		}
+
+		// Per entry access
+		inline const char* get_name(const size_t aIndex) const throw() { return mNames.data() + mNameOffsets[aIndex]; }
+		inline size_t get_name_length(const size_t aIndex) const throw() { return mNameOffsets[aIndex + 1] - mNameOffsets[aIndex] - 1; }
+		inline type get_type(const size_t aIndex) const throw() { return static_cast<type>(mTypes[aIndex]); }
+		inline uint64_t get_size(const size_t aIndex) const throw() { return mSizes[aIndex]; }
+		inline int64_t get_modified(const size_t aIndex) const throw() { return mModified[aIndex]; }
+		inline uint64_t get_inode(const size_t aIndex) const throw() { return mInodes[aIndex]; }
+
+		// Column access, each array has size() elements except name offsets which has size() + 1
+		inline const char* get_names() const throw() { return mNames.data(); }
+		inline const size_t* get_name_offsets() const throw() { return mNameOffsets.data(); }
+		inline const uint8_t* get_types() const throw() { return mTypes.data(); }
+		inline const uint64_t* get_sizes() const throw() { return mSizes.data(); }
+		inline const int64_t* get_modified() const throw() { return mModified.data(); }
+		inline const uint64_t* get_inodes() const throw() { return mInodes.data(); }
+	};
+}
+#endif
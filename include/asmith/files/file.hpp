@@ -23,6 +23,7 @@ namespace asmith {
 
 		file();
 		file(const char* aPath);
+		file(const char* aPath, const uint32_t aFlags);
 		
 		// Inherited from filesystem_object
 		uint32_t get_flags() const override;
@@ -14,13 +14,18 @@
 #ifndef ASMITH_FILES_FILESYSTEM_OBJECT_HPP
 #define ASMITH_FILES_FILESYSTEM_OBJECT_HPP
 
+#include <atomic>
 #include <string>
 #include <mutex>
 #include <memory>
 
 namespace asmith {
 	enum : char {
+#ifdef _WIN32
 		FILE_SEPERATOR = '\\'
+#else
+		FILE_SEPERATOR = '/'
+#endif
 	};
 
 	enum {
@@ -40,9 +45,14 @@ namespace asmith {
 	protected:
 		const std::string mPath;
 		mutable std::mutex mLock;
-		uint32_t mFlags;
+		std::atomic<uint32_t> mFlags;
 	protected:
-		static std::shared_ptr<filesystem_object> get_object_reference(const std::string&, const bool);
+		enum : uint32_t { UNKNOWN_FLAGS = 0xFFFFFFFF };
+
+		static std::shared_ptr<filesystem_object> get_object_reference(const std::string&, const bool, const uint32_t aFlags = UNKNOWN_FLAGS);
+#ifndef _WIN32
+		static uint32_t generate_flags(const char* aName, const uint32_t aMode) throw();
+#endif
 		
 		filesystem_object();
 		filesystem_object(const char* aPath);
@@ -0,0 +1,105 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#ifndef ASMITH_FILES_IO_SCHEDULER_HPP
+#define ASMITH_FILES_IO_SCHEDULER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace asmith {
+	enum io_priority : uint8_t {
+		IO_PRIORITY_HIGH,
+		IO_PRIORITY_NORMAL,
+		IO_PRIORITY_LOW,
+		IO_PRIORITY_COUNT
+	};
+
+	struct io_limits {
+		uint64_t bytes_per_second;		// 0 is unlimited
+		uint64_t operations_per_second;	// 0 is unlimited
+		uint32_t concurrency;			// 0 is unlimited
+	};
+
+	struct io_statistics {
+		uint32_t queued;
+		uint32_t max_queued;
+		uint32_t active;
+		uint64_t completed;
+		uint64_t bytes;
+	};
+
+	/*!
+		\brief Admission control for bulk file operations.
+		\detail Each operation acquires a ticket for its priority class before running on the
+		caller's thread. A class is held back by its own rate and concurrency limits, and
+		whenever a higher priority class has operations waiting.
+	*/
+	class io_scheduler {
+	private:
+		io_scheduler(io_scheduler&&) = delete;
+		io_scheduler(const io_scheduler&) = delete;
+		io_scheduler& operator=(io_scheduler&&) = delete;
+		io_scheduler& operator=(const io_scheduler&) = delete;
+	private:
+		typedef std::chrono::steady_clock clock;
+
+		struct priority_class {
+			io_limits limits;
+			io_statistics statistics;
+			double byte_tokens;
+			double operation_tokens;
+			clock::time_point refilled;
+		};
+
+		priority_class mClasses[IO_PRIORITY_COUNT];
+		mutable std::mutex mLock;
+		std::condition_variable mWake;
+
+		void refill(priority_class&, const clock::time_point) throw();
+		void release(const io_priority, const uint64_t) throw();
+	public:
+		class ticket {
+		private:
+			friend io_scheduler;
+
+			io_scheduler* mScheduler;
+			uint64_t mBytes;
+			io_priority mPriority;
+
+			ticket(io_scheduler*, const io_priority, const uint64_t);
+			ticket(const ticket&) = delete;
+			ticket& operator=(const ticket&) = delete;
+		public:
+			ticket(ticket&&);
+			ticket& operator=(ticket&&);
+			~ticket();
+
+			void release() throw();
+		};
+
+		static io_scheduler& get_default();
+
+		io_scheduler();
+		~io_scheduler();
+
+		ticket acquire(const io_priority aPriority, const uint64_t aBytes = 0);
+
+		io_limits get_limits(const io_priority aPriority) const;
+		void set_limits(const io_priority aPriority, const io_limits aLimits);
+		io_statistics get_statistics(const io_priority aPriority) const;
+	};
+}
+#endif
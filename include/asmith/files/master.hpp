@@ -16,7 +16,13 @@
 
 #include "filesystem_object.hpp"
 #include "file.hpp"
+#include "directory_listing.hpp"
+#include "directory_diff.hpp"
 #include "directory.hpp"
+#include "content_search.hpp"
+#include "bundle.hpp"
+#include "prefetcher.hpp"
+#include "io_scheduler.hpp"
 #include "file_wrapper.hpp"
 
 /*! 
@@ -0,0 +1,75 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#ifndef ASMITH_FILES_PREFETCHER_HPP
+#define ASMITH_FILES_PREFETCHER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include "directory.hpp"
+
+namespace asmith {
+
+	/*!
+		\brief Asks the operating system to load files into the page cache ahead of a consumer.
+		\detail A background thread stays up to a given number of files ahead of the position
+		reported through consume(), and stops early when the files it has prefetched but the
+		consumer has not yet reached would exceed the memory budget. The distance is counted in
+		files, the budget in bytes.
+	*/
+	class prefetcher {
+	private:
+		prefetcher(prefetcher&&) = delete;
+		prefetcher(const prefetcher&) = delete;
+		prefetcher& operator=(prefetcher&&) = delete;
+		prefetcher& operator=(const prefetcher&) = delete;
+	private:
+		std::vector<std::string> mPaths;
+		std::vector<uint64_t> mSizes;
+		std::thread mThread;
+		mutable std::mutex mLock;
+		std::condition_variable mWake;
+		const size_t mDistance;
+		const uint64_t mBudget;
+		size_t mPosition;
+		size_t mPrefetched;
+		uint64_t mInFlight;
+		std::atomic<bool> mStopped;
+
+		void worker();
+		void prefetch(const std::string&, const uint64_t) const;
+	public:
+		//! Bytes that may be prefetched ahead of the consumer, a single larger file is prefetched up to this size
+		enum : uint64_t { DEFAULT_BUDGET = 256 * 1024 * 1024 };
+
+		prefetcher(const std::vector<std::shared_ptr<file>>& aFiles, const size_t aDistance = 16, const uint64_t aBudget = DEFAULT_BUDGET);
+		prefetcher(const std::shared_ptr<directory>& aDirectory, const size_t aDistance = 16, const uint64_t aBudget = DEFAULT_BUDGET);
+		~prefetcher();
+
+		size_t size() const throw();
+		const char* get_path(const size_t aIndex) const throw();
+
+		/*!
+			\brief Report the consumer's position.
+			\param aIndex The index of the file the consumer is about to read. Every file before it
+			is finished and no longer counts against the budget, aIndex itself still does. Files
+			[aIndex, aIndex + distance) may be prefetched. Pass size() once the last file is done.
+		*/
+		void consume(const size_t aIndex);
+		void stop() throw();
+		size_t get_prefetched() const throw();
+	};
+}
+#endif
@@ -0,0 +1,393 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#include "asmith/files/bundle.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+#include "asmith/files/directory.hpp"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#include <io.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+namespace asmith {
+	enum : uint32_t {
+		BUNDLE_MAGIC = 0x42465341, // "ASFB"
+		BUNDLE_VERSION = 1
+	};
+
+	enum : size_t {
+		BUNDLE_HEADER_SIZE = 8,
+		BUNDLE_FOOTER_SIZE = 24,
+		BUNDLE_ENTRY_SIZE = 29,
+		BUNDLE_COPY_BUFFER = 1 << 16
+	};
+
+	// Integers are stored little endian regardless of the host
+
+	void write_integer(std::string& aBuffer, const uint64_t aValue, const size_t aBytes) {
+		for(size_t i = 0; i < aBytes; ++i) aBuffer += static_cast<char>((aValue >> (i * 8)) & 0xFF);
+	}
+
+	uint64_t read_integer(const uint8_t* aData, const size_t aBytes) throw() {
+		uint64_t value = 0;
+		for(size_t i = 0; i < aBytes; ++i) value |= static_cast<uint64_t>(aData[i]) << (i * 8);
+		return value;
+	}
+
+	// Names inside a bundle always use '/' so that bundles are portable between hosts
+
+	std::string to_bundle_name(const char* aName) {
+		std::string tmp = aName;
+		std::replace(tmp.begin(), tmp.end(), static_cast<char>(FILE_SEPERATOR), '/');
+		return tmp;
+	}
+
+	std::string from_bundle_name(const std::string& aName) {
+		std::string tmp = aName;
+		std::replace(tmp.begin(), tmp.end(), '/', static_cast<char>(FILE_SEPERATOR));
+		return tmp;
+	}
+
+	// Reject names that could resolve outside of the directory a bundle is unpacked into
+
+	bool is_safe_bundle_name(const std::string& aName) throw() {
+		// Only reject what could escape the unpack root on this host, ':' and '\\' are ordinary characters on POSIX
+		if(aName.empty() || aName[0] == '/') return false;
+#ifdef _WIN32
+		if(aName.find('\\') != std::string::npos || aName.find(':') != std::string::npos) return false;
+#endif
+		size_t begin = 0;
+		while(begin <= aName.size()) {
+			size_t end = aName.find('/', begin);
+			if(end == std::string::npos) end = aName.size();
+			const size_t length = end - begin;
+			if(length == 0) return false;
+			if(length == 1 && aName[begin] == '.') return false;
+			if(length == 2 && aName[begin] == '.' && aName[begin + 1] == '.') return false;
+			begin = end + 1;
+		}
+		return true;
+	}
+
+	// bundle
+
+	bool is_same_file(std::FILE* aFirst, std::FILE* aSecond) throw() {
+#ifdef _WIN32
+		BY_HANDLE_FILE_INFORMATION a;
+		BY_HANDLE_FILE_INFORMATION b;
+		if(! GetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(aFirst))), &a)) return false;
+		if(! GetFileInformationByHandle(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(aSecond))), &b)) return false;
+		return a.dwVolumeSerialNumber == b.dwVolumeSerialNumber && a.nFileIndexHigh == b.nFileIndexHigh && a.nFileIndexLow == b.nFileIndexLow;
+#else
+		struct stat a;
+		struct stat b;
+		if(fstat(fileno(aFirst), &a) != 0 || fstat(fileno(aSecond), &b) != 0) return false;
+		return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+#endif
+	}
+
+	bool is_regular_file(std::FILE* aFile) throw() {
+#ifdef _WIN32
+		return GetFileType(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(aFile)))) == FILE_TYPE_DISK;
+#else
+		struct stat s;
+		return fstat(fileno(aFile), &s) == 0 && S_ISREG(s.st_mode);
+#endif
+	}
+
+	void bundle::write(const std::string& aRoot, const directory_listing& aListing, const char* aPath) {
+		// Sort by bundle name so that the reader can binary search the index
+		const size_t count = aListing.size();
+		std::vector<std::string> names(count);
+		std::vector<size_t> order(count);
+		for(size_t i = 0; i < count; ++i) {
+			names[i] = to_bundle_name(aListing.get_name(i));
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&names](const size_t a, const size_t b) { return names[a] < names[b]; });
+
+		// Fail before anything is written rather than produce a bundle that the reader refuses to open
+		for(size_t i = 0; i < count; ++i) {
+			if(aListing.get_type(i) == directory_listing::TYPE_OTHER) continue;
+			if(! is_safe_bundle_name(names[i])) throw std::runtime_error("asmith::bundle::write : Unsafe entry name : " + names[i]);
+		}
+
+		std::FILE* const out = std::fopen(aPath, "wb");
+		if(out == nullptr) throw std::runtime_error("asmith::bundle::write : Failed to open bundle file");
+
+		// Never leave a truncated bundle behind, but only remove what this call created as a regular file
+		const bool removable = is_regular_file(out);
+		const auto fail = [out, aPath, removable](std::FILE* aInput, const std::string& aMessage) {
+			if(aInput != nullptr) std::fclose(aInput);
+			std::fclose(out);
+			if(removable) std::remove(aPath);
+			throw std::runtime_error("asmith::bundle::write : " + aMessage);
+		};
+
+		std::string header;
+		write_integer(header, BUNDLE_MAGIC, 4);
+		write_integer(header, BUNDLE_VERSION, 4);
+		if(std::fwrite(header.data(), 1, header.size(), out) != header.size()) fail(nullptr, "Failed to write bundle file");
+
+		std::string index;
+		std::vector<char> buffer(BUNDLE_COPY_BUFFER);
+		uint64_t offset = BUNDLE_HEADER_SIZE;
+		uint64_t entries = 0;
+		for(const size_t i : order) {
+			const directory_listing::type type = aListing.get_type(i);
+			if(type == directory_listing::TYPE_OTHER) continue;
+
+			uint64_t size = 0;
+			if(type == directory_listing::TYPE_FILE) {
+				std::FILE* const in = std::fopen((aRoot + aListing.get_name(i)).c_str(), "rb");
+				if(in == nullptr) fail(nullptr, "Failed to open file " + names[i]);
+
+				// The bundle may be inside the tree being packed, it must not pack itself
+				if(is_same_file(in, out)) {
+					std::fclose(in);
+					continue;
+				}
+
+				size_t bytes;
+				while((bytes = std::fread(buffer.data(), 1, buffer.size(), in)) > 0) {
+					if(std::fwrite(buffer.data(), 1, bytes, out) != bytes) fail(in, "Failed to write bundle file");
+					size += bytes;
+				}
+				if(std::ferror(in)) fail(in, "Failed to read file " + names[i]);
+				std::fclose(in);
+			}
+
+			write_integer(index, offset, 8);
+			write_integer(index, size, 8);
+			write_integer(index, static_cast<uint64_t>(aListing.get_modified(i)), 8);
+			write_integer(index, type, 1);
+			write_integer(index, names[i].size(), 4);
+			index += names[i];
+			offset += size;
+			++entries;
+		}
+
+		std::string footer;
+		write_integer(footer, offset, 8);
+		write_integer(footer, entries, 8);
+		write_integer(footer, BUNDLE_VERSION, 4);
+		write_integer(footer, BUNDLE_MAGIC, 4);
+		if(std::fwrite(index.data(), 1, index.size(), out) != index.size()) fail(nullptr, "Failed to write bundle file");
+		if(std::fwrite(footer.data(), 1, footer.size(), out) != footer.size()) fail(nullptr, "Failed to write bundle file");
+		if(std::fclose(out) != 0) {
+			if(removable) std::remove(aPath);
+			throw std::runtime_error("asmith::bundle::write : Failed to write bundle file");
+		}
+	}
+
+	bundle::bundle(const char* aPath) :
+		mData(nullptr),
+		mSize(0),
+#ifdef _WIN32
+		mFile(INVALID_HANDLE_VALUE),
+		mMapping(NULL)
+#else
+		mFile(-1)
+#endif
+	{
+#ifdef _WIN32
+		mFile = CreateFileA(aPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, NULL);
+		if(mFile == INVALID_HANDLE_VALUE) throw std::runtime_error("asmith::bundle::bundle : Failed to open bundle : " + std::to_string(GetLastError()));
+		LARGE_INTEGER size;
+		if(! GetFileSizeEx(mFile, &size)) {
+			CloseHandle(mFile);
+			throw std::runtime_error("asmith::bundle::bundle : Failed to read bundle size : " + std::to_string(GetLastError()));
+		}
+		mSize = static_cast<size_t>(size.QuadPart);
+		if(mSize >= BUNDLE_HEADER_SIZE + BUNDLE_FOOTER_SIZE) {
+			mMapping = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+			if(mMapping != NULL) mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+		}
+#else
+		mFile = open(aPath, O_RDONLY | O_CLOEXEC);
+		if(mFile == -1) throw std::runtime_error("asmith::bundle::bundle : Failed to open bundle");
+		struct stat s;
+		if(fstat(mFile, &s) != 0) {
+			close(mFile);
+			throw std::runtime_error("asmith::bundle::bundle : Failed to read bundle size");
+		}
+		mSize = static_cast<size_t>(s.st_size);
+		if(mSize >= BUNDLE_HEADER_SIZE + BUNDLE_FOOTER_SIZE) {
+			void* const data = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, mFile, 0);
+			if(data != MAP_FAILED) mData = static_cast<const uint8_t*>(data);
+		}
+#endif
+
+		if(mData == nullptr) {
+			release();
+			throw std::runtime_error("asmith::bundle::bundle : File is not a bundle");
+		}
+		const uint8_t* const footer = mData + mSize - BUNDLE_FOOTER_SIZE;
+		if(read_integer(mData, 4) != BUNDLE_MAGIC || read_integer(footer + 20, 4) != BUNDLE_MAGIC || read_integer(footer + 16, 4) != BUNDLE_VERSION) {
+			release();
+			throw std::runtime_error("asmith::bundle::bundle : File is not a bundle");
+		}
+
+		const uint64_t indexOffset = read_integer(footer, 8);
+		const uint64_t count = read_integer(footer + 8, 8);
+		if(indexOffset < BUNDLE_HEADER_SIZE || indexOffset > mSize - BUNDLE_FOOTER_SIZE) {
+			release();
+			throw std::runtime_error("asmith::bundle::bundle : Bundle index is corrupt");
+		}
+		const uint8_t* i = mData + indexOffset;
+		for(uint64_t j = 0; j < count; ++j) {
+			if(static_cast<size_t>(footer - i) < BUNDLE_ENTRY_SIZE) {
+				release();
+				throw std::runtime_error("asmith::bundle::bundle : Bundle index is corrupt");
+			}
+			entry e;
+			e.offset = read_integer(i, 8);
+			e.size = read_integer(i + 8, 8);
+			e.modified = static_cast<int64_t>(read_integer(i + 16, 8));
+			e.type = static_cast<directory_listing::type>(i[24]);
+			const uint64_t length = read_integer(i + 25, 4);
+			i += BUNDLE_ENTRY_SIZE;
+
+			const bool valid =
+				length <= static_cast<uint64_t>(footer - i) &&
+				e.offset >= BUNDLE_HEADER_SIZE &&
+				e.offset <= indexOffset &&
+				e.size <= indexOffset - e.offset &&
+				(e.type == directory_listing::TYPE_FILE || e.type == directory_listing::TYPE_DIRECTORY);
+			if(! valid) {
+				release();
+				throw std::runtime_error("asmith::bundle::bundle : Bundle index is corrupt");
+			}
+			e.name.assign(reinterpret_cast<const char*>(i), static_cast<size_t>(length));
+			i += length;
+			if(! is_safe_bundle_name(e.name)) {
+				release();
+				throw std::runtime_error("asmith::bundle::bundle : Bundle contains an unsafe entry name : " + e.name);
+			}
+
+			// find() binary searches the index, so names must be unique and in order
+			if(! mEntries.empty() && ! (mEntries.back().name < e.name)) {
+				release();
+				throw std::runtime_error("asmith::bundle::bundle : Bundle index is corrupt");
+			}
+			mEntries.push_back(std::move(e));
+		}
+		if(i != footer) {
+			release();
+			throw std::runtime_error("asmith::bundle::bundle : Bundle index is corrupt");
+		}
+	}
+
+	bundle::~bundle() {
+		release();
+	}
+
+	void bundle::release() throw() {
+#ifdef _WIN32
+		if(mData != nullptr) UnmapViewOfFile(mData);
+		if(mMapping != NULL) CloseHandle(mMapping);
+		if(mFile != INVALID_HANDLE_VALUE) CloseHandle(mFile);
+		mMapping = NULL;
+		mFile = INVALID_HANDLE_VALUE;
+#else
+		if(mData != nullptr) munmap(const_cast<uint8_t*>(mData), mSize);
+		if(mFile != -1) close(mFile);
+		mFile = -1;
+#endif
+		mData = nullptr;
+	}
+
+	size_t bundle::size() const throw() {
+		return mEntries.size();
+	}
+
+	size_t bundle::find(const char* aName) const throw() {
+		const std::string name = to_bundle_name(aName);
+		const auto i = std::lower_bound(mEntries.begin(), mEntries.end(), name, [](const entry& a, const std::string& b) { return a.name < b; });
+		if(i == mEntries.end() || i->name != name) return mEntries.size();
+		return static_cast<size_t>(i - mEntries.begin());
+	}
+
+	const char* bundle::get_name(const size_t aIndex) const throw() {
+		return mEntries[aIndex].name.c_str();
+	}
+
+	directory_listing::type bundle::get_type(const size_t aIndex) const throw() {
+		return mEntries[aIndex].type;
+	}
+
+	uint64_t bundle::get_size(const size_t aIndex) const throw() {
+		return mEntries[aIndex].size;
+	}
+
+	int64_t bundle::get_modified(const size_t aIndex) const throw() {
+		return mEntries[aIndex].modified;
+	}
+
+	const uint8_t* bundle::get_data(const size_t aIndex) const throw() {
+		return mData + mEntries[aIndex].offset;
+	}
+
+	void bundle::unpack(const char* aPath, const size_t aThreads) const {
+		std::shared_ptr<directory> root = directory::get_reference(aPath);
+		if(! root->exists()) root->create(FILE_READ | FILE_WRITE);
+		const std::string rootPath = root->get_path();
+
+		// Entries are sorted, so every directory is created before its children
+		for(const entry& i : mEntries) {
+			if(i.type != directory_listing::TYPE_DIRECTORY) continue;
+			std::shared_ptr<directory> tmp = directory::get_reference((rootPath + from_bundle_name(i.name)).c_str());
+			if(! tmp->exists()) tmp->create(FILE_READ | FILE_WRITE);
+		}
+
+		std::atomic<size_t> next(0);
+		std::atomic<bool> failed(false);
+		const auto worker = [&]() {
+			while(! failed) {
+				const size_t i = next++;
+				if(i >= mEntries.size()) break;
+				const entry& e = mEntries[i];
+				if(e.type != directory_listing::TYPE_FILE) continue;
+				std::FILE* const out = std::fopen((rootPath + from_bundle_name(e.name)).c_str(), "wb");
+				if(out == nullptr) {
+					failed = true;
+					break;
+				}
+				const size_t size = static_cast<size_t>(e.size);
+				if(std::fwrite(mData + e.offset, 1, size, out) != size) failed = true;
+				if(std::fclose(out) != 0) failed = true;
+			}
+		};
+
+		size_t threads = aThreads == 0 ? std::thread::hardware_concurrency() : aThreads;
+		if(threads == 0) threads = 1;
+		std::vector<std::thread> pool;
+		for(size_t i = 1; i < threads; ++i) pool.push_back(std::thread(worker));
+		worker();
+		for(std::thread& i : pool) i.join();
+
+		if(failed) throw std::runtime_error("asmith::bundle::unpack : Failed to write file");
+	}
+}
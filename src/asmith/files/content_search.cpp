@@ -0,0 +1,281 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#include "asmith/files/content_search.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define ASMITH_FILES_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace asmith {
+	enum {
+		BINARY_PROBE_SIZE = 8192,
+		MAX_VECTOR_FIRST_BYTES = 8
+	};
+
+#ifdef _WIN32
+	int64_t read_block(const HANDLE aHandle, uint8_t* aBuffer, const size_t aSize) throw() {
+#else
+	int64_t read_block(const int aHandle, uint8_t* aBuffer, const size_t aSize) throw() {
+#endif
+		// Keep reading until the block is full or the file ends, so a short block always means the end
+		size_t total = 0;
+		while(total < aSize) {
+#ifdef _WIN32
+			DWORD bytes = 0;
+			if(! ReadFile(aHandle, aBuffer + total, static_cast<DWORD>(std::min<size_t>(aSize - total, 1u << 30)), &bytes, NULL)) return -1;
+#else
+			const ssize_t bytes = read(aHandle, aBuffer + total, aSize - total);
+			if(bytes < 0) {
+				if(errno == EINTR) continue;
+				return -1;
+			}
+#endif
+			if(bytes == 0) break;
+			total += static_cast<size_t>(bytes);
+		}
+		return static_cast<int64_t>(total);
+	}
+
+	// content_search
+
+	content_search::content_search(const std::shared_ptr<directory>& aDirectory, const std::vector<std::string>& aPatterns, const uint32_t aFlags, const size_t aThreads) :
+		mRoot(aDirectory->get_path()),
+		mPatterns(aPatterns),
+		mFlags(aFlags),
+		mOverlap(0),
+		mCandidates(256),
+		mNext(0),
+		mCancelled(false),
+		mActive(0)
+	{
+		if(mPatterns.empty()) throw std::runtime_error("asmith::content_search::content_search : No patterns to search for");
+		for(size_t i = 0; i < mPatterns.size(); ++i) {
+			if(mPatterns[i].empty()) throw std::runtime_error("asmith::content_search::content_search : Pattern is empty");
+			const uint8_t first = static_cast<uint8_t>(mPatterns[i][0]);
+			if(mCandidates[first].empty()) mFirstBytes.push_back(first);
+			mCandidates[first].push_back(static_cast<uint32_t>(i));
+			// A match may start in the last (length - 1) bytes of a block and end in the next
+			mOverlap = std::max(mOverlap, mPatterns[i].size() - 1);
+		}
+
+		aDirectory->get_listing(mListing, true);
+
+		size_t threads = aThreads == 0 ? std::thread::hardware_concurrency() : aThreads;
+		if(threads == 0) threads = 1;
+		threads = std::min(threads, std::max<size_t>(mListing.size(), 1));
+		mActive = threads;
+		for(size_t i = 0; i < threads; ++i) mThreads.push_back(std::thread(&content_search::worker, this));
+	}
+
+	content_search::~content_search() {
+		cancel();
+		for(std::thread& i : mThreads) i.join();
+	}
+
+	void content_search::worker() {
+		std::vector<content_match> matches;
+		std::vector<uint8_t> buffer;
+		if(! (mFlags & SEARCH_MEMORY_MAP)) buffer.resize(mOverlap + std::max<size_t>(READ_BLOCK_SIZE, mOverlap + 1));
+		const size_t count = mListing.size();
+		while(! mCancelled) {
+			const size_t i = mNext++;
+			if(i >= count) break;
+			if(mListing.get_type(i) != directory_listing::TYPE_FILE || mListing.get_size(i) == 0) continue;
+			if(mFlags & SEARCH_MEMORY_MAP) map_file(mRoot + mListing.get_name(i), matches);
+			else search_file(mRoot + mListing.get_name(i), buffer, matches);
+			publish(matches);
+		}
+
+		std::lock_guard<std::mutex> lock(mLock);
+		--mActive;
+		mReady.notify_all();
+	}
+
+	void content_search::search_file(const std::string& aPath, std::vector<uint8_t>& aBuffer, std::vector<content_match>& aMatches) {
+#ifdef _WIN32
+		const HANDLE handle = CreateFileA(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(handle == INVALID_HANDLE_VALUE) return;
+#else
+		const int handle = open(aPath.c_str(), O_RDONLY | O_CLOEXEC);
+		if(handle == -1) return;
+		posix_fadvise(handle, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+		// Each block is scanned with the unverified tail of the previous block in front of it
+		uint8_t* const buffer = aBuffer.data();
+		const size_t block = aBuffer.size() - mOverlap;
+		const bool firstOnly = (mFlags & SEARCH_FIRST_MATCH) != 0;
+		uint64_t base = 0;
+		size_t carried = 0;
+		while(! mCancelled) {
+			const int64_t bytes = read_block(handle, buffer + carried, block);
+			if(bytes < 0) break;
+			const size_t size = carried + static_cast<size_t>(bytes);
+			// A short block means the end of the file, including one truncated during the scan
+			const bool last = static_cast<size_t>(bytes) < block;
+			if(base == 0 && (mFlags & SEARCH_SKIP_BINARY) && memchr(buffer, 0, std::min<size_t>(size, BINARY_PROBE_SIZE)) != nullptr) break;
+			const size_t limit = last ? size : size - mOverlap;
+			scan(buffer, size, limit, base, aPath, aMatches);
+			if(last || (firstOnly && ! aMatches.empty())) break;
+			carried = size - limit;
+			memmove(buffer, buffer + limit, carried);
+			base += limit;
+		}
+#ifdef _WIN32
+		CloseHandle(handle);
+#else
+		close(handle);
+#endif
+	}
+
+	void content_search::map_file(const std::string& aPath, std::vector<content_match>& aMatches) {
+#ifdef _WIN32
+		const HANDLE handle = CreateFileA(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(handle == INVALID_HANDLE_VALUE) return;
+		LARGE_INTEGER size;
+		if(GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+			const HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+			if(mapping != NULL) {
+				const void* const data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				if(data != NULL) {
+					const size_t bytes = static_cast<size_t>(size.QuadPart);
+					const bool binary = (mFlags & SEARCH_SKIP_BINARY) && memchr(data, 0, std::min<size_t>(bytes, BINARY_PROBE_SIZE)) != nullptr;
+					if(! binary) scan(static_cast<const uint8_t*>(data), bytes, bytes, 0, aPath, aMatches);
+					UnmapViewOfFile(data);
+				}
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(handle);
+#else
+		const int handle = open(aPath.c_str(), O_RDONLY | O_CLOEXEC);
+		if(handle == -1) return;
+		struct stat s;
+		if(fstat(handle, &s) == 0 && s.st_size > 0) {
+			const size_t bytes = static_cast<size_t>(s.st_size);
+			void* const data = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, handle, 0);
+			if(data != MAP_FAILED) {
+				madvise(data, bytes, MADV_SEQUENTIAL);
+				const bool binary = (mFlags & SEARCH_SKIP_BINARY) && memchr(data, 0, std::min<size_t>(bytes, BINARY_PROBE_SIZE)) != nullptr;
+				if(! binary) scan(static_cast<const uint8_t*>(data), bytes, bytes, 0, aPath, aMatches);
+				munmap(data, bytes);
+			}
+		}
+		close(handle);
+#endif
+	}
+
+	void content_search::scan(const uint8_t* aData, const size_t aSize, const size_t aLimit, const uint64_t aBase, const std::string& aPath, std::vector<content_match>& aMatches) const {
+		const bool firstOnly = (mFlags & SEARCH_FIRST_MATCH) != 0;
+		const size_t firstCount = mFirstBytes.size();
+		size_t i = 0;
+
+		if(firstCount == 1) {
+			// memchr is vectorised by the C library
+			const uint8_t first = mFirstBytes[0];
+			while(i < aLimit) {
+				const void* const found = memchr(aData + i, first, aLimit - i);
+				if(found == nullptr) return;
+				i = static_cast<const uint8_t*>(found) - aData;
+				verify(aData, aSize, i, aBase, aPath, aMatches);
+				if(firstOnly && ! aMatches.empty()) return;
+				++i;
+			}
+			return;
+		}
+
+#ifdef ASMITH_FILES_SSE2
+		if(firstCount <= MAX_VECTOR_FIRST_BYTES) {
+			__m128i firsts[MAX_VECTOR_FIRST_BYTES];
+			for(size_t j = 0; j < firstCount; ++j) firsts[j] = _mm_set1_epi8(static_cast<char>(mFirstBytes[j]));
+			while(i + 16 <= aLimit) {
+				const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(aData + i));
+				__m128i hits = _mm_cmpeq_epi8(block, firsts[0]);
+				for(size_t j = 1; j < firstCount; ++j) hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, firsts[j]));
+				uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(hits));
+				while(mask != 0) {
+					uint32_t bit = 0;
+					while(! (mask & (1u << bit))) ++bit;
+					mask &= mask - 1;
+					verify(aData, aSize, i + bit, aBase, aPath, aMatches);
+					if(firstOnly && ! aMatches.empty()) return;
+				}
+				i += 16;
+			}
+		}
+#endif
+
+		for(; i < aLimit; ++i) {
+			if(mCandidates[aData[i]].empty()) continue;
+			verify(aData, aSize, i, aBase, aPath, aMatches);
+			if(firstOnly && ! aMatches.empty()) return;
+		}
+	}
+
+	void content_search::verify(const uint8_t* aData, const size_t aSize, const size_t aOffset, const uint64_t aBase, const std::string& aPath, std::vector<content_match>& aMatches) const {
+		const std::vector<uint32_t>& candidates = mCandidates[aData[aOffset]];
+		for(const uint32_t i : candidates) {
+			const std::string& pattern = mPatterns[i];
+			if(aSize - aOffset < pattern.size()) continue;
+			if(memcmp(aData + aOffset, pattern.data(), pattern.size()) != 0) continue;
+			aMatches.push_back({aPath, aBase + aOffset, i});
+			if(mFlags & SEARCH_FIRST_MATCH) return;
+		}
+	}
+
+	void content_search::publish(std::vector<content_match>& aMatches) {
+		if(aMatches.empty()) return;
+		std::unique_lock<std::mutex> lock(mLock);
+		mSpace.wait(lock, [this]() { return mMatches.size() < MAX_QUEUED_MATCHES || mCancelled; });
+		if(! mCancelled) for(content_match& i : aMatches) mMatches.push_back(std::move(i));
+		aMatches.clear();
+		mReady.notify_all();
+	}
+
+	bool content_search::next(content_match& aMatch) {
+		std::unique_lock<std::mutex> lock(mLock);
+		mReady.wait(lock, [this]() { return ! mMatches.empty() || mActive == 0; });
+		if(mMatches.empty()) return false;
+		aMatch = std::move(mMatches.front());
+		mMatches.pop_front();
+		mSpace.notify_all();
+		return true;
+	}
+
+	void content_search::cancel() throw() {
+		std::lock_guard<std::mutex> lock(mLock);
+		mCancelled = true;
+		mMatches.clear();
+		mSpace.notify_all();
+		mReady.notify_all();
+	}
+
+	bool content_search::is_finished() const throw() {
+		std::lock_guard<std::mutex> lock(mLock);
+		return mActive == 0 && mMatches.empty();
+	}
+}
@@ -12,10 +12,27 @@
 //	limitations under the License.
 
 #include "asmith/files/directory.hpp"
+#include "asmith/files/bundle.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <list>
+#include <map>
+#include <cstring>
+#include <thread>
 
 #ifdef _WIN32
 	#define WIN32_LEAN_AND_MEAN
 	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <dirent.h>
+	#include <sys/stat.h>
+	#include <sys/resource.h>
 #endif
 
 namespace asmith {
@@ -25,6 +42,297 @@ namespace asmith {
 		return tmp;
 	}
 
+#ifndef _WIN32
+	// directory_handle_pool
+
+	class directory_handle_pool {
+	private:
+		struct entry {
+			std::string path;
+			int handle;
+			uint32_t users;
+		};
+
+		std::list<entry> mEntries;
+		std::list<entry> mClosing;
+		std::map<std::string, std::list<entry>::iterator> mIndex;
+		std::mutex mLock;
+		size_t mLimit;
+
+		void evict() {
+			// Close the least recently used handles that are not currently in use
+			auto i = mEntries.end();
+			while(mEntries.size() > mLimit && i != mEntries.begin()) {
+				--i;
+				if(i->users == 0) {
+					close(i->handle);
+					mIndex.erase(i->path);
+					i = mEntries.erase(i);
+				}
+			}
+		}
+	public:
+		directory_handle_pool() :
+			mLimit(64)
+		{
+			struct rlimit limit;
+			if(getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) mLimit = limit.rlim_cur / 4;
+			if(mLimit == 0) mLimit = 1;
+		}
+
+		~directory_handle_pool() {
+			for(entry& i : mEntries) close(i.handle);
+			for(entry& i : mClosing) close(i.handle);
+		}
+
+		int acquire(const std::string& aPath) {
+			std::lock_guard<std::mutex> lock(mLock);
+			const auto i = mIndex.find(aPath);
+			if(i != mIndex.end()) {
+				mEntries.splice(mEntries.begin(), mEntries, i->second);
+				++i->second->users;
+				return i->second->handle;
+			}
+			const int handle = open(aPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if(handle == -1) return -1;
+			mEntries.push_front({aPath, handle, 1});
+			mIndex.emplace(aPath, mEntries.begin());
+			evict();
+			return handle;
+		}
+
+		void release(const std::string& aPath, const int aHandle) {
+			std::lock_guard<std::mutex> lock(mLock);
+			const auto i = mIndex.find(aPath);
+			if(i != mIndex.end() && i->second->handle == aHandle) {
+				--i->second->users;
+				evict();
+				return;
+			}
+			// The handle was erased while in use, close it now that the last user is done
+			for(auto j = mClosing.begin(); j != mClosing.end(); ++j) if(j->handle == aHandle) {
+				if(--j->users == 0) {
+					close(j->handle);
+					mClosing.erase(j);
+				}
+				return;
+			}
+		}
+
+		void erase(const std::string& aPath) {
+			std::lock_guard<std::mutex> lock(mLock);
+			const auto i = mIndex.find(aPath);
+			if(i == mIndex.end()) return;
+			// Later acquires open a new handle, one still in use is closed by its last release
+			if(i->second->users > 0) {
+				mClosing.splice(mClosing.end(), mEntries, i->second);
+			} else {
+				close(i->second->handle);
+				mEntries.erase(i->second);
+			}
+			mIndex.erase(i);
+		}
+
+		size_t get_limit() throw() {
+			std::lock_guard<std::mutex> lock(mLock);
+			return mLimit;
+		}
+
+		void set_limit(const size_t aLimit) {
+			std::lock_guard<std::mutex> lock(mLock);
+			mLimit = aLimit;
+			evict();
+		}
+	};
+
+	directory_handle_pool& get_handle_pool() {
+		static directory_handle_pool POOL;
+		return POOL;
+	}
+
+	int stat_child(const std::string& aDirectory, const char* aName, const bool aCached, struct stat& aStat) {
+		if(aCached) {
+			directory_handle_pool& pool = get_handle_pool();
+			const int handle = pool.acquire(aDirectory);
+			if(handle != -1) {
+				const int result = fstatat(handle, aName, &aStat, 0);
+				pool.release(aDirectory, handle);
+				return result;
+			}
+		}
+		return stat((aDirectory + aName).c_str(), &aStat);
+	}
+
+	int open_directory_handle(const std::string& aDirectory, const bool aCached) {
+		// Open a fresh descriptor so that the cached handle's offset is not shared
+		if(aCached) {
+			directory_handle_pool& pool = get_handle_pool();
+			const int parent = pool.acquire(aDirectory);
+			if(parent != -1) {
+				const int handle = openat(parent, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				pool.release(aDirectory, parent);
+				if(handle != -1) return handle;
+			}
+		}
+		return open(aDirectory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	}
+
+	bool is_link(const std::string& aDirectory) throw() {
+		// The trailing separator would make lstat follow the link
+		struct stat s;
+		return lstat(aDirectory.substr(0, aDirectory.size() - 1).c_str(), &s) == 0 && S_ISLNK(s.st_mode);
+	}
+
+	void list_directory(const int aHandle, const std::string& aPrefix, const bool aRecursive, directory_listing& aListing) {
+		// An unreadable entry is an error, skipping it would make it look removed to diff. Entries removed while listing are skipped.
+		DIR* const dir = fdopendir(aHandle);
+		if(dir == nullptr) {
+			const int error = errno;
+			close(aHandle);
+			throw std::runtime_error("asmith::directory::get_listing : Failed to list " + aPrefix + " : " + std::to_string(error));
+		}
+		struct stat s;
+		std::string name;
+		try {
+			while(true) {
+				errno = 0;
+				const dirent* const i = readdir(dir);
+				if(i == nullptr) {
+					if(errno != 0) throw std::runtime_error("asmith::directory::get_listing : Failed to list " + aPrefix + " : " + std::to_string(errno));
+					break;
+				}
+				if(strcmp(i->d_name, ".") == 0 || strcmp(i->d_name, "..") == 0) continue;
+				name = aPrefix + i->d_name;
+				if(fstatat(aHandle, i->d_name, &s, AT_SYMLINK_NOFOLLOW) != 0) {
+					if(errno == ENOENT) continue;
+					throw std::runtime_error("asmith::directory::get_listing : Failed to stat " + name + " : " + std::to_string(errno));
+				}
+				const directory_listing::type type =
+					S_ISDIR(s.st_mode) ? directory_listing::TYPE_DIRECTORY :
+					S_ISREG(s.st_mode) ? directory_listing::TYPE_FILE :
+					directory_listing::TYPE_OTHER;
+				aListing.push_back(
+					name.c_str(),
+					name.size(),
+					type,
+					static_cast<uint64_t>(s.st_size),
+					static_cast<int64_t>(s.st_mtim.tv_sec) * 1000000000LL + s.st_mtim.tv_nsec,
+					static_cast<uint64_t>(s.st_ino)
+				);
+				if(aRecursive && type == directory_listing::TYPE_DIRECTORY) {
+					const int handle = openat(aHandle, i->d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+					if(handle == -1) {
+						if(errno == ENOENT) continue;
+						throw std::runtime_error("asmith::directory::get_listing : Failed to list " + name + " : " + std::to_string(errno));
+					}
+					name += FILE_SEPERATOR;
+					list_directory(handle, name, true, aListing);
+				}
+			}
+		} catch(...) {
+			closedir(dir);
+			throw;
+		}
+		closedir(dir);
+	}
+#else
+	bool is_link(const WIN32_FIND_DATAA& aData) throw() {
+		// Deduplicated and cloud placeholder files are also reparse points, but they are regular files
+		return (aData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && (aData.dwReserved0 == IO_REPARSE_TAG_SYMLINK || aData.dwReserved0 == IO_REPARSE_TAG_MOUNT_POINT);
+	}
+
+	bool is_link(const std::string& aDirectory) throw() {
+		WIN32_FIND_DATAA ffd;
+		const HANDLE handle = FindFirstFileA(aDirectory.substr(0, aDirectory.size() - 1).c_str(), &ffd);
+		if(handle == INVALID_HANDLE_VALUE) return false;
+		FindClose(handle);
+		return is_link(ffd);
+	}
+
+	void list_directory(const std::string& aPath, const std::string& aPrefix, const bool aRecursive, directory_listing& aListing) {
+		// An unreadable directory is an error, skipping it would make it look removed to diff. Directories removed while listing are skipped.
+		WIN32_FIND_DATAA ffd;
+		const HANDLE handle = FindFirstFileExA((aPath + '*').c_str(), FindExInfoBasic, &ffd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+		if(handle == INVALID_HANDLE_VALUE) {
+			const DWORD error = GetLastError();
+			if(! aPrefix.empty() && (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND)) return;
+			throw std::runtime_error("asmith::directory::get_listing : Failed to list " + aPrefix + " : " + std::to_string(error));
+		}
+		std::string name;
+		try {
+			do {
+				if(strcmp(ffd.cFileName, ".") == 0 || strcmp(ffd.cFileName, "..") == 0) continue;
+				name = aPrefix + ffd.cFileName;
+				// Junctions and symbolic links are reported but never followed, like lstat
+				const directory_listing::type type =
+					is_link(ffd) ? directory_listing::TYPE_OTHER :
+					ffd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY ? directory_listing::TYPE_DIRECTORY :
+					directory_listing::TYPE_FILE;
+				// FILETIME counts 100ns intervals since 1601
+				const int64_t modified = ((static_cast<int64_t>(ffd.ftLastWriteTime.dwHighDateTime) << 32) | ffd.ftLastWriteTime.dwLowDateTime) - 116444736000000000LL;
+				aListing.push_back(
+					name.c_str(),
+					name.size(),
+					type,
+					(static_cast<uint64_t>(ffd.nFileSizeHigh) << 32) | ffd.nFileSizeLow,
+					modified * 100,
+					0
+				);
+				if(aRecursive && type == directory_listing::TYPE_DIRECTORY) {
+					name += FILE_SEPERATOR;
+					list_directory(standardise_directory_path((aPath + ffd.cFileName).c_str()), name, true, aListing);
+				}
+			} while(FindNextFileA(handle, &ffd) != 0);
+			const DWORD error = GetLastError();
+			if(error != ERROR_NO_MORE_FILES) throw std::runtime_error("asmith::directory::get_listing : Failed to list " + aPrefix + " : " + std::to_string(error));
+		} catch(...) {
+			FindClose(handle);
+			throw;
+		}
+		FindClose(handle);
+	}
+#endif
+
+	std::vector<size_t> sort_listing(const directory_listing& aListing) {
+		std::vector<size_t> order(aListing.size());
+		for(size_t i = 0; i < order.size(); ++i) order[i] = i;
+		std::sort(order.begin(), order.end(), [&aListing](const size_t a, const size_t b) {
+			return strcmp(aListing.get_name(a), aListing.get_name(b)) < 0;
+		});
+		return order;
+	}
+
+	bool compare_contents(const std::string& aFirst, const std::string& aSecond) {
+		enum { BUFFER_SIZE = 1 << 16 };
+		// A file that cannot be read is an error, not a difference
+		std::FILE* const a = std::fopen(aFirst.c_str(), "rb");
+		if(a == nullptr) throw std::runtime_error("asmith::directory::diff : Failed to open " + aFirst);
+		std::FILE* const b = std::fopen(aSecond.c_str(), "rb");
+		if(b == nullptr) {
+			std::fclose(a);
+			throw std::runtime_error("asmith::directory::diff : Failed to open " + aSecond);
+		}
+		std::vector<char> bufferA(BUFFER_SIZE);
+		std::vector<char> bufferB(BUFFER_SIZE);
+		bool equal = true;
+		while(equal) {
+			const size_t sizeA = std::fread(bufferA.data(), 1, BUFFER_SIZE, a);
+			const size_t sizeB = std::fread(bufferB.data(), 1, BUFFER_SIZE, b);
+			const bool failedA = std::ferror(a) != 0;
+			const bool failedB = std::ferror(b) != 0;
+			if(failedA || failedB) {
+				std::fclose(a);
+				std::fclose(b);
+				throw std::runtime_error("asmith::directory::diff : Failed to read " + (failedA ? aFirst : aSecond));
+			}
+			if(sizeA != sizeB || memcmp(bufferA.data(), bufferB.data(), sizeA) != 0) equal = false;
+			if(sizeA < BUFFER_SIZE) break;
+		}
+		std::fclose(a);
+		std::fclose(b);
+		return equal;
+	}
+
 	// directory
 
 	std::shared_ptr<directory> directory::get_temporary_directory() {
@@ -36,6 +344,9 @@ namespace asmith {
 			if(GetTempPathA(MAX_PATH, BUFFER) > MAX_PATH) throw("asmith::directory::get_temporary_directory : Failed to locate temporary directory");
 		}
 		return get_reference(BUFFER);
+#else
+		const char* const path = getenv("TMPDIR");
+		return get_reference(path != nullptr && *path != '\0' ? path : "/tmp");
 #endif
 		throw("asmith::directory::get_temporary_directory : Failed to locate temporary directory");
 	}
@@ -64,21 +375,45 @@ namespace asmith {
 		return std::dynamic_pointer_cast<directory>(filesystem_object::get_object_reference(aPath, true));
 	}
 
+	size_t directory::get_handle_limit() throw() {
+#ifdef _WIN32
+		return 0;
+#else
+		return get_handle_pool().get_limit();
+#endif
+	}
+
+	void directory::set_handle_limit(const size_t aLimit) {
+#ifndef _WIN32
+		get_handle_pool().set_limit(aLimit);
+#endif
+	}
+
 	directory::directory() :
-		filesystem_object()
+		filesystem_object(),
+		mCacheHandle(false)
 	{}
 
 	directory::directory(const char* aPath) :
-		filesystem_object(standardise_directory_path(aPath).c_str())
+		filesystem_object(standardise_directory_path(aPath).c_str()),
+		mCacheHandle(false)
 	{
 		mFlags = get_flags();
 	}
 
+	directory::directory(const char* aPath, const uint32_t aFlags) :
+		filesystem_object(standardise_directory_path(aPath).c_str()),
+		mCacheHandle(false)
+	{
+		mFlags = aFlags;
+	}
+
 	directory::~directory() {
 		enum { DESTROY_FLAG = FILE_EXISTS | FILE_TEMPORARY};
 		if((mFlags & DESTROY_FLAG) == DESTROY_FLAG) {
 			destroy();
 		}
+		cache_handle(false);
 	}
 
 	uint32_t directory::get_flags() const {
@@ -91,6 +426,11 @@ namespace asmith {
 		flags |= wflags & FILE_ATTRIBUTE_READONLY ? FILE_READ : (FILE_WRITE | FILE_READ);
 		flags |= wflags & FILE_ATTRIBUTE_HIDDEN ? FILE_HIDDEN : 0;
 		flags |= FILE_EXISTS;
+#else
+		struct stat s;
+		if(stat(mPath.c_str(), &s) != 0) return flags;
+		if(! S_ISDIR(s.st_mode)) throw std::runtime_error("asmith::directory::get_flags : Object is a file not a directory");
+		flags |= generate_flags(get_name(), s.st_mode);
 #endif
 		return flags;
 	}
@@ -104,6 +444,13 @@ namespace asmith {
 			path.c_str(), 
 			flags & FILE_ATTRIBUTE_DIRECTORY
 		);
+#else
+		struct stat s;
+		if(stat_child(mPath, aPath, mCacheHandle, s) == 0) return filesystem_object::get_object_reference(
+			path.c_str(),
+			S_ISDIR(s.st_mode),
+			generate_flags(aPath, s.st_mode)
+		);
 #endif
 		return std::shared_ptr<filesystem_object>();
 	}
@@ -143,10 +490,203 @@ namespace asmith {
 			}while(FindNextFileA(handle, &ffd) != 0);
 		}
 		FindClose(handle);
+#else
+		const int handle = open_directory_handle(mPath, mCacheHandle);
+		if(handle == -1) throw std::runtime_error("asmith::directory::get_children : Failed to open directory");
+		DIR* const dir = fdopendir(handle);
+		if(dir == nullptr) {
+			close(handle);
+			throw std::runtime_error("asmith::directory::get_children : Failed to open directory");
+		}
+		struct stat s;
+		while(const dirent* const i = readdir(dir)) {
+			if(strcmp(i->d_name, ".") == 0 || strcmp(i->d_name, "..") == 0) continue;
+			// Links are returned as files so that destroy removes the link rather than its target
+			if(fstatat(handle, i->d_name, &s, AT_SYMLINK_NOFOLLOW) != 0) continue;
+			children.push_back(filesystem_object::get_object_reference(
+				mPath + i->d_name,
+				S_ISDIR(s.st_mode),
+				generate_flags(i->d_name, s.st_mode)
+			));
+		}
+		closedir(dir);
 #endif
 		return children;
 	}
 
+	directory_listing directory::get_listing(const bool aRecursive) const {
+		directory_listing listing;
+		get_listing(listing, aRecursive);
+		return listing;
+	}
+
+	void directory::get_listing(directory_listing& aListing, const bool aRecursive) const {
+		if(! exists()) throw std::runtime_error("asmith::directory::get_listing : Directory does not exist");
+		aListing.clear();
+#ifdef _WIN32
+		list_directory(mPath, std::string(), aRecursive, aListing);
+#else
+		const int handle = open_directory_handle(mPath, mCacheHandle);
+		if(handle == -1) throw std::runtime_error("asmith::directory::get_listing : Failed to open directory");
+		list_directory(handle, std::string(), aRecursive, aListing);
+#endif
+	}
+
+	std::shared_ptr<file> directory::pack(const char* aPath) const {
+		bundle::write(mPath, get_listing(true), aPath);
+		return file::get_reference(aPath);
+	}
+
+	std::vector<diff_entry> directory::diff(const std::shared_ptr<directory>& aOther, const uint32_t aFlags, const size_t aThreads) const {
+		if(! exists()) throw std::runtime_error("asmith::directory::diff : Directory does not exist");
+		if(! aOther->exists()) throw std::runtime_error("asmith::directory::diff : Other directory does not exist");
+
+		// List both trees at the same time
+		directory_listing before;
+		directory_listing after;
+		std::exception_ptr error;
+		std::thread other([&]() {
+			try {
+				aOther->get_listing(after, true);
+			} catch(...) {
+				error = std::current_exception();
+			}
+		});
+		try {
+			get_listing(before, true);
+		} catch(...) {
+			other.join();
+			throw;
+		}
+		other.join();
+		if(error) std::rethrow_exception(error);
+
+		const std::vector<size_t> orderBefore = sort_listing(before);
+		const std::vector<size_t> orderAfter = sort_listing(after);
+
+		// Merge the sorted listings, deferring files that metadata alone cannot decide
+		std::vector<diff_entry> changes;
+		std::vector<size_t> pending;
+		size_t i = 0;
+		size_t j = 0;
+		while(i < orderBefore.size() || j < orderAfter.size()) {
+			const size_t a = i < orderBefore.size() ? orderBefore[i] : 0;
+			const size_t b = j < orderAfter.size() ? orderAfter[j] : 0;
+			const int cmp =
+				i == orderBefore.size() ? 1 :
+				j == orderAfter.size() ? -1 :
+				strcmp(before.get_name(a), after.get_name(b));
+
+			if(cmp < 0) {
+				changes.push_back({before.get_name(a), diff_entry::REMOVED});
+				++i;
+			} else if(cmp > 0) {
+				changes.push_back({after.get_name(b), diff_entry::ADDED});
+				++j;
+			} else {
+				if(before.get_type(a) != after.get_type(b)) {
+					changes.push_back({before.get_name(a), diff_entry::TYPE_CHANGED});
+				} else if(before.get_type(a) == directory_listing::TYPE_FILE) {
+					if(before.get_size(a) != after.get_size(b)) {
+						changes.push_back({before.get_name(a), diff_entry::MODIFIED});
+					} else if((aFlags & DIFF_COMPARE_CONTENTS) || before.get_modified(a) != after.get_modified(b)) {
+						pending.push_back(changes.size());
+						changes.push_back({before.get_name(a), diff_entry::MODIFIED});
+					}
+				}
+				++i;
+				++j;
+			}
+		}
+
+		// Compare the contents of undecided files in parallel
+		if(! pending.empty()) {
+			std::vector<char> equal(pending.size(), 0);
+			std::atomic<size_t> next(0);
+			std::mutex errorLock;
+			const std::string otherPath = aOther->get_path();
+			const auto worker = [&]() {
+				size_t k;
+				while((k = next++) < pending.size()) {
+					const std::string& name = changes[pending[k]].name;
+					try {
+						equal[k] = compare_contents(mPath + name, otherPath + name);
+					} catch(...) {
+						// Keep the first error and stop the other workers from taking more files
+						std::lock_guard<std::mutex> lock(errorLock);
+						if(! error) error = std::current_exception();
+						next = pending.size();
+					}
+				}
+			};
+			size_t threads = aThreads == 0 ? std::thread::hardware_concurrency() : aThreads;
+			threads = std::max<size_t>(std::min(threads, pending.size()), 1);
+			std::vector<std::thread> pool;
+			for(size_t k = 1; k < threads; ++k) pool.push_back(std::thread(worker));
+			worker();
+			for(std::thread& k : pool) k.join();
+			if(error) std::rethrow_exception(error);
+
+			for(size_t k = 0; k < pending.size(); ++k) if(equal[k]) changes[pending[k]].name.clear();
+			changes.erase(std::remove_if(changes.begin(), changes.end(), [](const diff_entry& e) { return e.name.empty(); }), changes.end());
+		}
+
+		return changes;
+	}
+
+	void directory::destroy(io_scheduler& aScheduler, const io_priority aPriority) {
+		if(! exists()) throw std::runtime_error("asmith::directory::destroy : Directory does not exist");
+
+		if(! is_link(mPath)) {
+			std::vector<std::shared_ptr<filesystem_object>> children = get_children();
+			for(std::shared_ptr<filesystem_object>& i : children) {
+				if(i->is_directory()) {
+					std::static_pointer_cast<directory>(i)->destroy(aScheduler, aPriority);
+				} else {
+					const io_scheduler::ticket ticket = aScheduler.acquire(aPriority);
+					i->destroy();
+				}
+			}
+		}
+
+		const io_scheduler::ticket ticket = aScheduler.acquire(aPriority);
+		destroy();
+	}
+
+	std::shared_ptr<filesystem_object> directory::copy(const char* aPath, io_scheduler& aScheduler, const io_priority aPriority) {
+		if(! exists()) throw std::runtime_error("asmith::directory::copy : Directory does not exist");
+		std::shared_ptr<directory> destination = directory::get_reference(aPath);
+		if(! destination->exists()) {
+			const io_scheduler::ticket ticket = aScheduler.acquire(aPriority);
+			destination->create(FILE_READ | FILE_WRITE);
+		}
+
+		std::vector<std::shared_ptr<filesystem_object>> children = get_children();
+		for(std::shared_ptr<filesystem_object>& i : children) {
+			const std::string path = destination->get_path() + std::string(i->get_path() + mPath.size());
+			if(i->is_directory()) {
+				std::static_pointer_cast<directory>(i)->copy(path.c_str(), aScheduler, aPriority);
+			} else {
+				const io_scheduler::ticket ticket = aScheduler.acquire(aPriority, static_cast<const file*>(i.get())->size());
+				i->copy(path.c_str());
+			}
+		}
+
+		return destination;
+	}
+
+	bool directory::is_handle_cached() const throw() {
+		return mCacheHandle;
+	}
+
+	void directory::cache_handle(const bool aCache) {
+#ifdef _WIN32
+		mCacheHandle = aCache;
+#else
+		if(mCacheHandle.exchange(aCache) && ! aCache) get_handle_pool().erase(mPath);
+#endif
+	}
+
 	void directory::hide() {
 		//! \todo Implement
 		throw std::runtime_error("asmith::directory::hide : Failed to hide directory");
@@ -160,35 +700,47 @@ namespace asmith {
 	}
 
 	void directory::create(const uint32_t aFlags) {
-		if(exists()) throw std::runtime_error("asmith::directory::destroy : Directory already exists");
 		std::lock_guard<std::mutex> lock(mLock);
+		if(exists()) throw std::runtime_error("asmith::directory::create : Directory already exists");
 #ifdef _WIN32
 		if(! CreateDirectoryA(mPath.c_str(), NULL)) throw std::runtime_error("asmith::directory::create : Failed to create directory : " + std::to_string(GetLastError()));
 		mFlags = aFlags | FILE_EXISTS;
 		return;
+#else
+		if(mkdir(mPath.c_str(), aFlags & FILE_WRITE ? 0777 : 0555) != 0) throw std::runtime_error("asmith::directory::create : Failed to create directory : " + std::to_string(errno));
+		mFlags = aFlags | FILE_EXISTS;
+		return;
 #endif
 		throw std::runtime_error("asmith::directory::create : Failed to create directory");
 	}
 
 	void directory::destroy() {
-		if(! exists()) throw std::runtime_error("asmith::directory::destroy : Directory does not exist");
-		std::lock_guard<std::mutex> lock(mLock);
-
-		std::vector<std::shared_ptr<filesystem_object>> children = get_children();
-		for(std::shared_ptr<filesystem_object>& i : children) i->destroy();
+		// Children are destroyed without holding this directory's lock, a link to a directory is removed without touching its target
+		const bool link = is_link(mPath);
+		if(exists() && ! link) {
+			std::vector<std::shared_ptr<filesystem_object>> children = get_children();
+			for(std::shared_ptr<filesystem_object>& i : children) if(i->exists()) i->destroy();
+		}
 
+		std::lock_guard<std::mutex> lock(mLock);
+		if(! exists()) throw std::runtime_error("asmith::directory::destroy : Directory does not exist");
 #ifdef _WIN32
 		if(! RemoveDirectoryA(mPath.c_str())) throw std::runtime_error("asmith::directory::destroy : Failed to destroy directory : " + std::to_string(GetLastError()));
 		mFlags = 0;
 		return;
+#else
+		if((link ? unlink(mPath.substr(0, mPath.size() - 1).c_str()) : rmdir(mPath.c_str())) != 0) throw std::runtime_error("asmith::directory::destroy : Failed to destroy directory : " + std::to_string(errno));
+		get_handle_pool().erase(mPath);
+		mFlags = 0;
+		return;
 #endif
 		throw std::runtime_error("asmith::directory::destroy : Failed to destroy directory");
 		
 	}
 
 	std::shared_ptr<filesystem_object> directory::move(const char* aPath) {
-		if(! exists()) throw std::runtime_error("asmith::directory::move : Directory does not exist");
 		std::lock_guard<std::mutex> lock(mLock);
+		if(! exists()) throw std::runtime_error("asmith::directory::move : Directory does not exist");
 #ifdef _WIN32
 		if(! MoveFileExA(mPath.c_str(), aPath, MOVEFILE_REPLACE_EXISTING)) throw std::runtime_error("asmith::directory::move : Failed to move directory : " + std::to_string(GetLastError()));
 		mFlags = get_flags();
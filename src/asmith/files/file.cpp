@@ -16,6 +16,11 @@
 #ifdef _WIN32
 	#define WIN32_LEAN_AND_MEAN
 	#include <windows.h>
+#else
+	#include <cerrno>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/stat.h>
 #endif
 
 namespace asmith {
@@ -45,6 +50,12 @@ namespace asmith {
 		mFlags = get_flags();
 	}
 
+	file::file(const char* aPath, const uint32_t aFlags) :
+		filesystem_object(aPath)
+	{
+		mFlags = aFlags;
+	}
+
 	file::~file() {
 		enum { DESTROY_FLAG = FILE_EXISTS | FILE_TEMPORARY};
 		if((mFlags & DESTROY_FLAG) == DESTROY_FLAG) {
@@ -62,6 +73,11 @@ namespace asmith {
 		flags |= wflags & FILE_ATTRIBUTE_READONLY ? FILE_READ : (FILE_WRITE | FILE_READ);
 		flags |= wflags & FILE_ATTRIBUTE_HIDDEN ? FILE_HIDDEN : 0;
 		flags |= FILE_EXISTS;
+#else
+		struct stat s;
+		if(stat(mPath.c_str(), &s) != 0) return flags;
+		if(S_ISDIR(s.st_mode)) throw std::runtime_error("asmith::file::get_flags : Object is a directory not a file");
+		flags |= generate_flags(get_name(), s.st_mode);
 #endif
 		return flags;
 	}
@@ -96,6 +112,9 @@ namespace asmith {
 			// Close file handle
 			CloseHandle(handle);
 		}
+#else
+		struct stat s;
+		if(stat(mPath.c_str(), &s) == 0) size = static_cast<size_t>(s.st_size);
 #endif
 		return size;
 	}
@@ -103,8 +122,9 @@ namespace asmith {
 	void file::hide() {
 		if(is_hidden()) throw std::runtime_error("asmith::file::hide : File is already hidden");
 #ifdef _WIN32
+		std::lock_guard<std::mutex> lock(mLock);
+		if(! SetFileAttributesA(mPath.c_str(), generate_file_attributes(mFlags | FILE_HIDDEN))) throw std::runtime_error("asmith::file::hide : Failed to set file attributes : " + std::to_string(GetLastError()));
 		mFlags |= FILE_HIDDEN;
-		if(! SetFileAttributesA(mPath.c_str(), generate_file_attributes(mFlags))) throw std::runtime_error("asmith::file::hide : Failed to set file attributes : " + std::to_string(GetLastError()));
 		return;
 #endif
 		throw std::runtime_error("asmith::file::hide : Failed to hide file");
@@ -113,16 +133,17 @@ namespace asmith {
 	void file::show() {
 		if(! is_hidden()) throw std::runtime_error("asmith::file::show : File is not hidden");
 #ifdef _WIN32
-		mFlags = mFlags & (~FILE_HIDDEN);
-		if(! SetFileAttributesA(mPath.c_str(), generate_file_attributes(mFlags))) throw std::runtime_error("asmith::file::show : Failed to set file attributes : " + std::to_string(GetLastError()));
+		std::lock_guard<std::mutex> lock(mLock);
+		if(! SetFileAttributesA(mPath.c_str(), generate_file_attributes(mFlags & ~FILE_HIDDEN))) throw std::runtime_error("asmith::file::show : Failed to set file attributes : " + std::to_string(GetLastError()));
+		mFlags &= ~FILE_HIDDEN;
 		return;
 #endif
 		throw std::runtime_error("asmith::file::show : Failed to show file");
 	}
 
 	void file::create(const uint32_t aFlags) {
-		if(exists()) throw std::runtime_error("asmith::file::destroy : File already exists");
 		std::lock_guard<std::mutex> lock(mLock);
+		if(exists()) throw std::runtime_error("asmith::file::create : File already exists");
 #ifdef _WIN32
 		HANDLE handle = CreateFileA(
 			mPath.c_str(),
@@ -137,24 +158,34 @@ namespace asmith {
 		CloseHandle(handle);
 		mFlags = aFlags | FILE_EXISTS;
 		return;
+#else
+		const int handle = open(mPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, aFlags & FILE_WRITE ? 0666 : 0444);
+		if(handle == -1) throw std::runtime_error("asmith::file::create : Failed to create file : " + std::to_string(errno));
+		close(handle);
+		mFlags = aFlags | FILE_EXISTS;
+		return;
 #endif
 		throw std::runtime_error("asmith::file::create : Failed to create file");
 	}
 
 	void file::destroy() {
-		if(! exists()) throw std::runtime_error("asmith::file::destroy : File does not exist");
 		std::lock_guard<std::mutex> lock(mLock);
+		if(! exists()) throw std::runtime_error("asmith::file::destroy : File does not exist");
 #ifdef _WIN32
 		if(! DeleteFileA(mPath.c_str())) throw std::runtime_error("asmith::file::destroy : Failed to destroy file");
 		mFlags = 0;
 		return;
+#else
+		if(unlink(mPath.c_str()) != 0) throw std::runtime_error("asmith::file::destroy : Failed to destroy file : " + std::to_string(errno));
+		mFlags = 0;
+		return;
 #endif
 		throw std::runtime_error("asmith::file::destroy : Failed to destroy file");
 	}
 
 	std::shared_ptr<filesystem_object> file::move(const char* aPath) {
-		if(! exists()) throw std::runtime_error("asmith::file::move : File does not exist");
 		std::lock_guard<std::mutex> lock(mLock);
+		if(! exists()) throw std::runtime_error("asmith::file::move : File does not exist");
 #ifdef _WIN32
 		if(! MoveFileA(mPath.c_str(), aPath)) throw std::runtime_error("asmith::file::move : Failed to move file : " + std::to_string(GetLastError()));
 		mFlags = get_flags();
@@ -165,10 +196,65 @@ namespace asmith {
 
 	std::shared_ptr<filesystem_object> file::copy(const char* aPath) {
 		if(! exists()) throw std::runtime_error("asmith::file::copy : File does not exist");
-		std::lock_guard<std::mutex> lock(mLock);
 #ifdef _WIN32
 		if(! CopyFileA(mPath.c_str(), aPath, FALSE)) throw std::runtime_error("asmith::file::copy : Failed to copy file : " + std::to_string(GetLastError()));
 		return get_reference(aPath);
+#else
+		enum { BUFFER_SIZE = 1 << 16 };
+		// Like CopyFile, replace any existing destination and keep the source's permissions
+		const int in = open(mPath.c_str(), O_RDONLY | O_CLOEXEC);
+		if(in == -1) throw std::runtime_error("asmith::file::copy : Failed to copy file : " + std::to_string(errno));
+		struct stat s;
+		if(fstat(in, &s) != 0) {
+			const int error = errno;
+			close(in);
+			throw std::runtime_error("asmith::file::copy : Failed to copy file : " + std::to_string(error));
+		}
+		const int out = open(aPath, O_CREAT | O_WRONLY | O_CLOEXEC, s.st_mode & 0777);
+		if(out == -1) {
+			const int error = errno;
+			close(in);
+			throw std::runtime_error("asmith::file::copy : Failed to copy file : " + std::to_string(error));
+		}
+
+		// Truncate only after checking that the destination is not the source
+		struct stat d;
+		if(fstat(out, &d) != 0 || (d.st_dev == s.st_dev && d.st_ino == s.st_ino) || ftruncate(out, 0) != 0) {
+			close(in);
+			close(out);
+			throw std::runtime_error("asmith::file::copy : Failed to copy file");
+		}
+		posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+		char buffer[BUFFER_SIZE];
+		int error = 0;
+		while(error == 0) {
+			const ssize_t bytes = read(in, buffer, BUFFER_SIZE);
+			if(bytes == 0) break;
+			if(bytes < 0) {
+				if(errno != EINTR) error = errno;
+				continue;
+			}
+			ssize_t written = 0;
+			while(written < bytes) {
+				const ssize_t count = write(out, buffer + written, static_cast<size_t>(bytes - written));
+				if(count < 0) {
+					if(errno == EINTR) continue;
+					error = errno;
+					break;
+				}
+				written += count;
+			}
+		}
+		close(in);
+		if(close(out) != 0 && error == 0) error = errno;
+
+		// Never leave a partial copy behind
+		if(error != 0) {
+			unlink(aPath);
+			throw std::runtime_error("asmith::file::copy : Failed to copy file : " + std::to_string(error));
+		}
+		return get_reference(aPath);
 #endif
 		throw std::runtime_error("asmith::file::copy : Failed to copy file");
 	}
@@ -19,6 +19,8 @@
 #ifdef _WIN32
 	#define WIN32_LEAN_AND_MEAN
 	#include <windows.h>
+#else
+	#include <sys/stat.h>
 #endif
 
 namespace asmith {
@@ -34,22 +36,33 @@ namespace asmith {
 		return 0;
 	}
 
-	std::shared_ptr<filesystem_object> filesystem_object::get_object_reference(const std::string& aPath, const bool aDirectory) {
+	std::shared_ptr<filesystem_object> filesystem_object::get_object_reference(const std::string& aPath, const bool aDirectory, const uint32_t aFlags) {
 		std::shared_ptr<filesystem_object> tmp;
 		FILE_MAP_LOCK.lock();
 		const auto i = FILE_MAP.find(aPath);
 		if(i != FILE_MAP.end()) tmp = i->second.lock();
 		if(! tmp) {
+			// Flags already read by the caller save the constructor from querying the filesystem again
+			const bool known = aFlags != UNKNOWN_FLAGS;
 			tmp = std::shared_ptr<filesystem_object>(
-				aDirectory ? static_cast<filesystem_object*>(new directory(aPath.c_str())) :
-				static_cast<filesystem_object*>(new file(aPath.c_str()))
+				aDirectory ? static_cast<filesystem_object*>(known ? new directory(aPath.c_str(), aFlags) : new directory(aPath.c_str())) :
+				static_cast<filesystem_object*>(known ? new file(aPath.c_str(), aFlags) : new file(aPath.c_str()))
 			);
 			FILE_MAP.emplace(aPath, tmp);
 		}
 		FILE_MAP_LOCK.unlock();
 		return tmp;
 	}
-	
+
+#ifndef _WIN32
+	uint32_t filesystem_object::generate_flags(const char* aName, const uint32_t aMode) throw() {
+		uint32_t flags = FILE_EXISTS;
+		if(aMode & S_IRUSR) flags |= FILE_READ;
+		if(aMode & S_IWUSR) flags |= FILE_WRITE;
+		if(aName[0] == '.') flags |= FILE_HIDDEN;
+		return flags;
+	}
+#endif
 	
 	filesystem_object::filesystem_object() :
 		mPath(),
@@ -110,10 +123,10 @@ namespace asmith {
 	}
 	
 	bool filesystem_object::is_read_only() const throw() {
-		return is_readable() && ! is_writeable();
+		return (mFlags & (FILE_READ | FILE_WRITE)) == FILE_READ;
 	}
 	
 	bool filesystem_object::is_write_only() const throw() {
-		return is_writeable() && ! is_readable();;
+		return (mFlags & (FILE_READ | FILE_WRITE)) == FILE_WRITE;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,162 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#include "asmith/files/io_scheduler.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace asmith {
+
+	// io_scheduler::ticket
+
+	io_scheduler::ticket::ticket(io_scheduler* aScheduler, const io_priority aPriority, const uint64_t aBytes) :
+		mScheduler(aScheduler),
+		mBytes(aBytes),
+		mPriority(aPriority)
+	{}
+
+	io_scheduler::ticket::ticket(ticket&& aOther) :
+		mScheduler(aOther.mScheduler),
+		mBytes(aOther.mBytes),
+		mPriority(aOther.mPriority)
+	{
+		aOther.mScheduler = nullptr;
+	}
+
+	io_scheduler::ticket& io_scheduler::ticket::operator=(ticket&& aOther) {
+		if(this != &aOther) {
+			release();
+			mScheduler = aOther.mScheduler;
+			mBytes = aOther.mBytes;
+			mPriority = aOther.mPriority;
+			aOther.mScheduler = nullptr;
+		}
+		return *this;
+	}
+
+	io_scheduler::ticket::~ticket() {
+		release();
+	}
+
+	void io_scheduler::ticket::release() throw() {
+		if(mScheduler == nullptr) return;
+		mScheduler->release(mPriority, mBytes);
+		mScheduler = nullptr;
+	}
+
+	// io_scheduler
+
+	io_scheduler& io_scheduler::get_default() {
+		static io_scheduler SCHEDULER;
+		return SCHEDULER;
+	}
+
+	io_scheduler::io_scheduler() {
+		const clock::time_point now = clock::now();
+		for(priority_class& i : mClasses) {
+			i.limits = {0, 0, 0};
+			i.statistics = {0, 0, 0, 0, 0};
+			i.byte_tokens = 0.0;
+			i.operation_tokens = 0.0;
+			i.refilled = now;
+		}
+	}
+
+	io_scheduler::~io_scheduler() {
+
+	}
+
+	void io_scheduler::refill(priority_class& aClass, const clock::time_point aNow) throw() {
+		// Buckets hold at most one second of their rate
+		const double seconds = std::chrono::duration<double>(aNow - aClass.refilled).count();
+		aClass.refilled = aNow;
+		const double bytes = static_cast<double>(aClass.limits.bytes_per_second);
+		const double operations = static_cast<double>(aClass.limits.operations_per_second);
+		aClass.byte_tokens = std::min(aClass.byte_tokens + seconds * bytes, bytes);
+		aClass.operation_tokens = std::min(aClass.operation_tokens + seconds * operations, operations);
+	}
+
+	io_scheduler::ticket io_scheduler::acquire(const io_priority aPriority, const uint64_t aBytes) {
+		if(aPriority >= IO_PRIORITY_COUNT) throw std::runtime_error("asmith::io_scheduler::acquire : Invalid priority");
+		std::unique_lock<std::mutex> lock(mLock);
+		priority_class& c = mClasses[aPriority];
+		++c.statistics.queued;
+		c.statistics.max_queued = std::max(c.statistics.max_queued, c.statistics.queued);
+
+		while(true) {
+			const clock::time_point now = clock::now();
+			refill(c, now);
+
+			bool higherWaiting = false;
+			for(int i = 0; i < aPriority; ++i) if(mClasses[i].statistics.queued > 0) higherWaiting = true;
+			const io_limits& limits = c.limits;
+			const bool concurrencyOk = limits.concurrency == 0 || c.statistics.active < limits.concurrency;
+
+			// Operations larger than a full bucket are admitted once the bucket is full and leave it in debt
+			const double byteCost = std::min(static_cast<double>(aBytes), static_cast<double>(limits.bytes_per_second));
+			const double byteDeficit = limits.bytes_per_second == 0 ? 0.0 : byteCost - c.byte_tokens;
+			const double operationDeficit = limits.operations_per_second == 0 ? 0.0 : 1.0 - c.operation_tokens;
+
+			if(! higherWaiting && concurrencyOk && byteDeficit <= 0.0 && operationDeficit <= 0.0) {
+				if(limits.bytes_per_second != 0) c.byte_tokens -= static_cast<double>(aBytes);
+				if(limits.operations_per_second != 0) c.operation_tokens -= 1.0;
+				--c.statistics.queued;
+				++c.statistics.active;
+				mWake.notify_all();
+				return ticket(this, aPriority, aBytes);
+			}
+
+			if(! higherWaiting && concurrencyOk) {
+				// Only the rate limits are in the way, sleep until enough tokens have accumulated
+				double seconds = 0.0;
+				if(byteDeficit > 0.0) seconds = std::max(seconds, byteDeficit / static_cast<double>(limits.bytes_per_second));
+				if(operationDeficit > 0.0) seconds = std::max(seconds, operationDeficit / static_cast<double>(limits.operations_per_second));
+				mWake.wait_until(lock, now + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(seconds)));
+			} else {
+				mWake.wait(lock);
+			}
+		}
+	}
+
+	void io_scheduler::release(const io_priority aPriority, const uint64_t aBytes) throw() {
+		std::lock_guard<std::mutex> lock(mLock);
+		io_statistics& s = mClasses[aPriority].statistics;
+		--s.active;
+		++s.completed;
+		s.bytes += aBytes;
+		mWake.notify_all();
+	}
+
+	io_limits io_scheduler::get_limits(const io_priority aPriority) const {
+		if(aPriority >= IO_PRIORITY_COUNT) throw std::runtime_error("asmith::io_scheduler::get_limits : Invalid priority");
+		std::lock_guard<std::mutex> lock(mLock);
+		return mClasses[aPriority].limits;
+	}
+
+	void io_scheduler::set_limits(const io_priority aPriority, const io_limits aLimits) {
+		if(aPriority >= IO_PRIORITY_COUNT) throw std::runtime_error("asmith::io_scheduler::set_limits : Invalid priority");
+		std::lock_guard<std::mutex> lock(mLock);
+		priority_class& c = mClasses[aPriority];
+		refill(c, clock::now());
+		c.limits = aLimits;
+		c.byte_tokens = std::min(c.byte_tokens, static_cast<double>(aLimits.bytes_per_second));
+		c.operation_tokens = std::min(c.operation_tokens, static_cast<double>(aLimits.operations_per_second));
+		mWake.notify_all();
+	}
+
+	io_statistics io_scheduler::get_statistics(const io_priority aPriority) const {
+		if(aPriority >= IO_PRIORITY_COUNT) throw std::runtime_error("asmith::io_scheduler::get_statistics : Invalid priority");
+		std::lock_guard<std::mutex> lock(mLock);
+		return mClasses[aPriority].statistics;
+	}
+}
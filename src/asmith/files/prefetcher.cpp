@@ -0,0 +1,145 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+#include "asmith/files/prefetcher.hpp"
+#include <algorithm>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace asmith {
+
+	// prefetcher
+
+	prefetcher::prefetcher(const std::vector<std::shared_ptr<file>>& aFiles, const size_t aDistance, const uint64_t aBudget) :
+		mDistance(std::max<size_t>(aDistance, 1)),
+		mBudget(aBudget),
+		mPosition(0),
+		mPrefetched(0),
+		mInFlight(0),
+		mStopped(false)
+	{
+		mPaths.reserve(aFiles.size());
+		mSizes.reserve(aFiles.size());
+		for(const std::shared_ptr<file>& i : aFiles) {
+			mPaths.push_back(i->get_path());
+			mSizes.push_back(i->exists() ? i->size() : 0);
+		}
+		mThread = std::thread(&prefetcher::worker, this);
+	}
+
+	prefetcher::prefetcher(const std::shared_ptr<directory>& aDirectory, const size_t aDistance, const uint64_t aBudget) :
+		mDistance(std::max<size_t>(aDistance, 1)),
+		mBudget(aBudget),
+		mPosition(0),
+		mPrefetched(0),
+		mInFlight(0),
+		mStopped(false)
+	{
+		const directory_listing listing = aDirectory->get_listing(true);
+		const std::string root = aDirectory->get_path();
+		for(size_t i = 0; i < listing.size(); ++i) {
+			if(listing.get_type(i) != directory_listing::TYPE_FILE) continue;
+			mPaths.push_back(root + listing.get_name(i));
+			mSizes.push_back(listing.get_size(i));
+		}
+		mThread = std::thread(&prefetcher::worker, this);
+	}
+
+	prefetcher::~prefetcher() {
+		stop();
+		mThread.join();
+	}
+
+	void prefetcher::worker() {
+		std::unique_lock<std::mutex> lock(mLock);
+		while(! mStopped && mPrefetched < mPaths.size()) {
+			// Wait until the next file is within the distance and fits in the budget
+			const size_t i = mPrefetched;
+			const bool ready =
+				i < mPosition + mDistance &&
+				(mInFlight == 0 || mInFlight + mSizes[i] <= mBudget);
+			if(! ready) {
+				mWake.wait(lock);
+				continue;
+			}
+
+			const std::string path = mPaths[i];
+			const uint64_t size = std::min(mSizes[i], mBudget);
+			mInFlight += size;
+			mPrefetched = i + 1;
+			lock.unlock();
+			prefetch(path, size);
+			lock.lock();
+		}
+	}
+
+	void prefetcher::prefetch(const std::string& aPath, const uint64_t aSize) const {
+		if(aSize == 0) return;
+#ifdef _WIN32
+		// Windows has no advisory read ahead for plain handles, so read through the file to warm the cache
+		const HANDLE handle = CreateFileA(aPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+		if(handle == INVALID_HANDLE_VALUE) return;
+		enum { BUFFER_SIZE = 1 << 16 };
+		std::vector<char> buffer(BUFFER_SIZE);
+		uint64_t remaining = aSize;
+		DWORD bytes = 0;
+		while(remaining > 0 && ! mStopped && ReadFile(handle, buffer.data(), BUFFER_SIZE, &bytes, NULL) && bytes > 0) {
+			remaining -= std::min<uint64_t>(remaining, bytes);
+		}
+		CloseHandle(handle);
+#else
+		const int handle = open(aPath.c_str(), O_RDONLY | O_CLOEXEC);
+		if(handle == -1) return;
+		posix_fadvise(handle, 0, static_cast<off_t>(aSize), POSIX_FADV_WILLNEED);
+		close(handle);
+#endif
+	}
+
+	size_t prefetcher::size() const throw() {
+		return mPaths.size();
+	}
+
+	const char* prefetcher::get_path(const size_t aIndex) const throw() {
+		return mPaths[aIndex].c_str();
+	}
+
+	void prefetcher::consume(const size_t aIndex) {
+		std::lock_guard<std::mutex> lock(mLock);
+		const size_t position = std::min(aIndex, mPaths.size());
+		if(position <= mPosition) return;
+
+		// Files the consumer has moved past no longer count against the budget
+		const size_t end = std::min(position, mPrefetched);
+		for(size_t i = mPosition; i < end; ++i) mInFlight -= std::min(mSizes[i], mBudget);
+		mPosition = position;
+		if(mPrefetched < mPosition) mPrefetched = mPosition;
+		mWake.notify_one();
+	}
+
+	void prefetcher::stop() throw() {
+		std::lock_guard<std::mutex> lock(mLock);
+		mStopped = true;
+		mWake.notify_one();
+	}
+
+	size_t prefetcher::get_prefetched() const throw() {
+		std::lock_guard<std::mutex> lock(mLock);
+		return mPrefetched;
+	}
+}
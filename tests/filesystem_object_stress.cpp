@@ -0,0 +1,109 @@
+//	Copyright 2017 Adam Smith
+//	Licensed under the Apache License, Version 2.0 (the "License");
+//	you may not use this file except in compliance with the License.
+//	You may obtain a copy of the License at
+// 
+//	http://www.apache.org/licenses/LICENSE-2.0
+//
+//	Unless required by applicable law or agreed to in writing, software
+//	distributed under the License is distributed on an "AS IS" BASIS,
+//	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//	See the License for the specific language governing permissions and
+//	limitations under the License.
+
+// Readers poll the state of filesystem objects while writers create and destroy them.
+//
+// Build and run from the repository root :
+//	g++ -std=c++11 -O2 -pthread -Iinclude tests/filesystem_object_stress.cpp src/asmith/files/*.cpp -o filesystem_object_stress
+//	./filesystem_object_stress [parent directory]
+//
+// Add -fsanitize=thread to check for data races. Exits with a non-zero status on failure.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "asmith/files/master.hpp"
+
+using namespace asmith;
+
+enum {
+	OBJECT_COUNT = 32,
+	WRITER_ITERATIONS = 2000,
+	READER_COUNT = 4
+};
+
+int main(int argc, char** argv) {
+	// Always work in a new directory so that nothing which already exists is destroyed
+	const std::shared_ptr<directory> parent = argc > 1 ? directory::get_reference(argv[1]) : directory::get_temporary_directory();
+	std::shared_ptr<directory> root = parent->get_directory(("asmith_files_stress_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count())).c_str());
+	root->create(FILE_READ | FILE_WRITE);
+
+	std::vector<std::shared_ptr<filesystem_object>> objects;
+	for(int i = 0; i < OBJECT_COUNT; ++i) {
+		const std::string name = std::to_string(i);
+		if(i % 2 == 0) objects.push_back(root->get_file((name + ".txt").c_str()));
+		else objects.push_back(root->get_directory(name.c_str()));
+	}
+
+	std::atomic<bool> done(false);
+	std::atomic<uint32_t> failures(0);
+	std::atomic<uint64_t> reads(0);
+
+	// Readers never lock, and must never see a contradictory state
+	std::vector<std::thread> readers;
+	for(int i = 0; i < READER_COUNT; ++i) readers.push_back(std::thread([&]() {
+		uint64_t count = 0;
+		while(! done) {
+			for(const std::shared_ptr<filesystem_object>& j : objects) {
+				const bool exists = j->exists();
+				const bool hidden = j->is_hidden();
+				if(j->is_read_only() && j->is_write_only()) ++failures;
+				if(! exists && hidden) ++failures;
+				++count;
+			}
+		}
+		reads += count;
+	}));
+
+	// Two writers race on every object, exactly one create and one destroy may win each round
+	std::atomic<uint32_t> creates(0);
+	std::atomic<uint32_t> destroys(0);
+	const auto writer = [&]() {
+		for(int i = 0; i < WRITER_ITERATIONS; ++i) {
+			std::shared_ptr<filesystem_object>& object = objects[i % OBJECT_COUNT];
+			try {
+				object->create(FILE_READ | FILE_WRITE);
+				++creates;
+			} catch(std::exception&) {}
+			try {
+				object->destroy();
+				++destroys;
+			} catch(std::exception&) {}
+		}
+	};
+	std::thread writerA(writer);
+	std::thread writerB(writer);
+	writerA.join();
+	writerB.join();
+
+	done = true;
+	for(std::thread& i : readers) i.join();
+
+	// Every successful create must be matched by exactly one successful destroy
+	for(const std::shared_ptr<filesystem_object>& i : objects) if(i->exists()) {
+		++failures;
+		std::printf("FAIL : %s still exists\n", i->get_path());
+	}
+	if(creates != destroys) {
+		++failures;
+		std::printf("FAIL : %u creates but %u destroys\n", creates.load(), destroys.load());
+	}
+
+	root->destroy();
+
+	std::printf("%llu reads, %u creates, %u destroys, %u failures\n", static_cast<unsigned long long>(reads.load()), creates.load(), destroys.load(), failures.load());
+	std::printf(failures == 0 ? "PASS\n" : "FAIL\n");
+	return failures == 0 ? 0 : 1;
+}